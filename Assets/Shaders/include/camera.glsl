@@ -0,0 +1,12 @@
+// shared with every renderer shader (Renderer.h CAMERA_UNIFORM_BINDING), uploaded before the first draw after
+// a change: the time every frame, the matrices when the camera changes and the size when the viewport does
+
+layout(std140, binding = 0) uniform Camera
+{
+	mat4 u_projection;
+	mat4 u_view;
+	mat4 u_viewProjection;
+	vec2 u_viewportSize;
+	float u_time;
+	float u_deltaTime;
+};
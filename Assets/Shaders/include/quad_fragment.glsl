@@ -0,0 +1,66 @@
+// fragment shader of every quads shader, the permutation picks how the texture id is resolved:
+// TEXTURE_ARRAYS: one array per texture size, the texture id holds the array in the high bits and the layer in the low bits
+// BINDLESS_TEXTURES: handles of every texture drawn so far, indexed by the texture id
+// DRAW_TEXTURES: bindless handles of the 32 slots of every draw, indexed by the draw id
+// none: texture slots
+
+#if defined(BINDLESS_TEXTURES) || defined(DRAW_TEXTURES)
+#extension GL_ARB_bindless_texture : require
+#endif
+
+in vec2 v_textureUv;
+in vec4 v_color;
+flat in int v_textureId;
+
+#if defined(TEXTURE_ARRAYS)
+
+uniform sampler2DArray u_textureArrays[32];
+
+vec4 SampleQuadTexture()
+{
+	return texture(u_textureArrays[v_textureId >> 16], vec3(v_textureUv, v_textureId & 0xFFFF));
+}
+
+#elif defined(BINDLESS_TEXTURES)
+
+layout(std430, binding = 0) readonly buffer TextureHandles
+{
+	uvec2 u_textureHandles[];
+};
+
+vec4 SampleQuadTexture()
+{
+	return texture(sampler2D(u_textureHandles[v_textureId]), v_textureUv);
+}
+
+#elif defined(DRAW_TEXTURES)
+
+flat in int v_drawId;
+
+layout(std430, binding = 2) readonly buffer DrawTextures
+{
+	uvec2 u_drawTextures[];
+};
+
+vec4 SampleQuadTexture()
+{
+	return texture(sampler2D(u_drawTextures[v_drawId * 32 + v_textureId]), v_textureUv);
+}
+
+#else
+
+uniform sampler2D u_textures[32];
+
+vec4 SampleQuadTexture()
+{
+	return texture(u_textures[v_textureId], v_textureUv);
+}
+
+#endif
+
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+	o_color = SampleQuadTexture() * v_color;
+}
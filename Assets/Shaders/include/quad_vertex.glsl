@@ -0,0 +1,29 @@
+// preamble of the quads vertex shaders, included right after #version
+// DRAW_TEXTURES: slots with multi draw indirect, the fragment shader reads the texture table of the draw
+
+#ifdef DRAW_TEXTURES
+#extension GL_ARB_shader_draw_parameters : require
+#endif
+
+#include "camera.glsl"
+
+out vec2 v_textureUv;
+out vec4 v_color;
+flat out int v_textureId;
+
+#ifdef DRAW_TEXTURES
+flat out int v_drawId;
+#endif
+
+void OutputQuadVertex(vec2 position, vec2 textureUv, vec4 color, int textureId)
+{
+	v_textureUv = textureUv;
+	v_color = color;
+	v_textureId = textureId;
+
+#ifdef DRAW_TEXTURES
+	v_drawId = gl_DrawIDARB;
+#endif
+
+	gl_Position = u_viewProjection * vec4(position, 0.0, 1.0);
+}
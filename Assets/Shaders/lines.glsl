@@ -0,0 +1,30 @@
+#type vertex
+#version 450 core
+
+// packed vertex: the color is normalized
+
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in vec4 a_color;
+
+#include "include/camera.glsl"
+
+out vec4 v_color;
+
+void main()
+{
+	v_color = a_color;
+
+	gl_Position = u_viewProjection * vec4(a_position, 0.0, 1.0);
+}
+
+#type fragment
+#version 450 core
+
+in vec4 v_color;
+
+layout(location = 0) out vec4 o_color;
+
+void main()
+{
+	o_color = v_color;
+}
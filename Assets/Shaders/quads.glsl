@@ -0,0 +1,19 @@
+#type vertex
+#version 450 core
+#include "include/quad_vertex.glsl"
+
+// packed vertex: the color is normalized, the texture id is an integer
+
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in uint a_textureId;
+layout(location = 2) in vec2 a_textureUv;
+layout(location = 3) in vec4 a_color;
+
+void main()
+{
+	OutputQuadVertex(a_position, a_textureUv, a_color, int(a_textureId));
+}
+
+#type fragment
+#version 450 core
+#include "include/quad_fragment.glsl"
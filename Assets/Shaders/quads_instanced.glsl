@@ -0,0 +1,34 @@
+#type vertex
+#version 450 core
+#include "include/quad_vertex.glsl"
+
+// unit quad
+
+layout(location = 0) in vec2 a_corner;
+
+// instance
+
+layout(location = 1) in vec2 a_position;
+layout(location = 2) in vec2 a_size;
+layout(location = 3) in float a_rotation;
+layout(location = 4) in float a_textureId;
+layout(location = 5) in vec4 a_textureRect;
+layout(location = 6) in vec4 a_color;
+
+void main()
+{
+	// scale and rotate the corner around the center of the quad
+
+	vec2 corner = a_corner * a_size;
+
+	float c = cos(a_rotation);
+	float s = sin(a_rotation);
+
+	vec2 position = a_position + vec2(corner.x * c - corner.y * s, corner.x * s + corner.y * c);
+
+	OutputQuadVertex(position, a_textureRect.xy + (a_corner + 0.5) * a_textureRect.zw, a_color, int(a_textureId));
+}
+
+#type fragment
+#version 450 core
+#include "include/quad_fragment.glsl"
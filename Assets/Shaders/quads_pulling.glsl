@@ -0,0 +1,44 @@
+#type vertex
+#version 450 core
+#include "include/quad_vertex.glsl"
+
+// quads pulled from the storage buffer, 6 vertices per quad and no vertex attributes
+// 14 floats per quad: position (center), size, rotation, texture id, texture rect, color
+
+layout(std430, binding = 1) readonly buffer Quads
+{
+	float u_quads[];
+};
+
+const vec2 corners[6] = vec2[](
+	vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(0.5, 0.5),
+	vec2(0.5, 0.5), vec2(-0.5, 0.5), vec2(-0.5, -0.5)
+);
+
+void main()
+{
+	int base = (gl_VertexID / 6) * 14;
+	vec2 unitCorner = corners[gl_VertexID % 6];
+
+	vec2 center = vec2(u_quads[base], u_quads[base + 1]);
+	vec2 size = vec2(u_quads[base + 2], u_quads[base + 3]);
+	float rotation = u_quads[base + 4];
+	float textureId = u_quads[base + 5];
+	vec4 textureRect = vec4(u_quads[base + 6], u_quads[base + 7], u_quads[base + 8], u_quads[base + 9]);
+	vec4 color = vec4(u_quads[base + 10], u_quads[base + 11], u_quads[base + 12], u_quads[base + 13]);
+
+	// scale and rotate the corner around the center of the quad
+
+	vec2 corner = unitCorner * size;
+
+	float c = cos(rotation);
+	float s = sin(rotation);
+
+	vec2 position = center + vec2(corner.x * c - corner.y * s, corner.x * s + corner.y * c);
+
+	OutputQuadVertex(position, textureRect.xy + (unitCorner + 0.5) * textureRect.zw, color, int(textureId));
+}
+
+#type fragment
+#version 450 core
+#include "include/quad_fragment.glsl"
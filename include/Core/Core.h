@@ -9,11 +9,20 @@
 #include <imgui/imgui_impl_opengl3.h>
 
 #include "Renderer/Shader.h"
+#include "Renderer/ShaderLibrary.h"
 #include "Renderer/Texture.h"
+#include "Renderer/TextureRegion.h"
+#include "Renderer/TextureAtlas.h"
+#include "Renderer/TextureStreamer.h"
 #include "Renderer/Framebuffer.h"
 #include "Renderer/Buffer.h"
 #include "Renderer/VertexArray.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/CommandList.h"
+#include "Renderer/SpatialGrid.h"
+#include "Renderer/StaticBatch.h"
+#include "Renderer/GpuProfiler.h"
+#include "Renderer/RenderState.h"
 
 #include "OrthoCamera.h"
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include "Rect.h"
 
 class OrthoCamera
 {
@@ -9,12 +10,33 @@ public:
 
 	void SetSize(int width, int height);
 
-	void SetPosition(const glm::vec2& position) { m_position = position; }
+	void SetPosition(const glm::vec2& position);
+	void SetZoom(float zoom); // around the center of the view
+	void SetRotation(float radians); // around the center of the view
+
 	const glm::vec2& GetPosition() const { return m_position; }
+	float GetZoom() const { return m_zoom; }
+	float GetRotation() const { return m_rotation; }
+	const glm::vec2& GetSize() const { return m_size; }
+
+	// cached, recalculated when the camera changes
+
 	const glm::mat4& GetProjection() const { return m_projection; }
-	glm::mat4 GetView() const;
+	const glm::mat4& GetView() const { return m_view; }
+	const glm::mat4& GetViewProjection() const { return m_viewProjection; }
+	const Rect& GetVisibleRect() const { return m_visibleRect; } // world space bounds of what the camera sees
+
+private:
+	void Recalculate();
 
 private:
 	glm::vec2 m_position;
+	glm::vec2 m_size;
+	float m_zoom;
+	float m_rotation;
+
 	glm::mat4 m_projection;
-};
\ No newline at end of file
+	glm::mat4 m_view;
+	glm::mat4 m_viewProjection;
+	Rect m_visibleRect;
+};
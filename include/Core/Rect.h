@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cmath>
+
+// axis aligned rectangle in world space
+
+struct Rect
+{
+	glm::vec2 min;
+	glm::vec2 max;
+
+	bool Overlaps(const Rect& other) const
+	{
+		return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y;
+	}
+
+	// bounds of a quad rotated around its center
+
+	static Rect FromQuad(const glm::vec2& center, const glm::vec2& size, float radians)
+	{
+		glm::vec2 halfSize = glm::abs(size) * 0.5f;
+
+		if (radians != 0.0f)
+		{
+			float c = std::abs(std::cos(radians));
+			float s = std::abs(std::sin(radians));
+
+			halfSize = { halfSize.x * c + halfSize.y * s, halfSize.x * s + halfSize.y * c };
+		}
+
+		return { center - halfSize, center + halfSize };
+	}
+};
@@ -2,12 +2,16 @@
 
 #include <vector>
 #include <cstddef>
+#include "VertexLayout.h"
 
 struct VertexBufferElement
 {
 	unsigned int count;
 	unsigned int type;
 	size_t elementSize;
+	size_t offset;
+	bool normalized; // unsigned integers read as floats in [0, 1]
+	bool integer; // read as integers by the shader
 };
 
 class VertexBufferLayout
@@ -17,13 +21,64 @@ public:
 
 	const std::vector<VertexBufferElement>& GetElements() const { return m_elements; }
 	size_t GetStride() const { return m_stride; }
+	unsigned int GetDivisor() const { return m_divisor; }
 
 	template<typename T>
 	void AddElement(unsigned int count);
 
+	void AddAttribute(const VertexAttribute& attribute);
+
+	// layout derived from the VertexLayout of a vertex struct, checked at compile time
+
+	template<typename Vertex>
+	static VertexBufferLayout Create(unsigned int divisor = 0)
+	{
+		static_assert(IsVertexLayoutValid<Vertex>(), "the attributes of the vertex layout do not match the vertex struct");
+
+		VertexBufferLayout layout;
+
+		for (const VertexAttribute& attribute : VertexLayout<Vertex>::attributes)
+			layout.AddAttribute(attribute);
+
+		layout.SetDivisor(divisor);
+
+		return layout;
+	}
+
+	void SetDivisor(unsigned int divisor) { m_divisor = divisor; } // 1 to advance the elements per instance
+
 private:
 	std::vector<VertexBufferElement> m_elements;
 	size_t m_stride;
+	unsigned int m_divisor;
+};
+
+// persistent mapped ring of regions guarded by fences, the cpu writes a region while the gpu still reads
+// the ones before it (the streaming vertex buffers and the pixel unpack buffer)
+
+class PersistentRing
+{
+public:
+	PersistentRing();
+	~PersistentRing();
+
+	void Create(unsigned int target, size_t regionSize, unsigned int regionsCount); // storage of the buffer bound to target
+
+	void* LockRegion(); // waits until the gpu has finished reading the region
+	void UnlockRegion(); // fences the commands issued so far and moves to the next region
+
+	bool IsMapped() const { return m_mappedPtr != nullptr; }
+	size_t GetRegionSize() const { return m_regionSize; }
+	size_t GetRegionOffset() const { return m_regionIndex * m_regionSize; }
+
+	PersistentRing(const PersistentRing&) = delete;
+	PersistentRing& operator=(const PersistentRing&) = delete;
+
+private:
+	unsigned char* m_mappedPtr;
+	size_t m_regionSize;
+	unsigned int m_regionIndex;
+	std::vector<void*> m_fences;
 };
 
 class VertexBuffer
@@ -34,15 +89,27 @@ public:
 
 	void Create(size_t size);
 	void Create(size_t size, const void* data);
+	void CreateStreaming(size_t regionSize, unsigned int regionsCount);
 
 	void SetData(size_t size, const void* data);
+	void SetData(size_t offset, size_t size, const void* data);
 
 	void Bind() const;
 	void UnBind() const;
 
+	// streaming (persistent mapped ring of regions guarded by fences)
+
+	void* LockRegion() { return m_ring.LockRegion(); }
+	void UnlockRegion() { m_ring.UnlockRegion(); }
+
+	bool IsStreaming() const { return m_ring.IsMapped(); }
+	size_t GetRegionSize() const { return m_ring.GetRegionSize(); }
+	size_t GetRegionOffset() const { return m_ring.GetRegionOffset(); }
+
 private:
 	unsigned int m_id;
 	size_t m_size;
+	PersistentRing m_ring; // streaming
 };
 
 class IndexBuffer
@@ -63,3 +130,89 @@ private:
 	unsigned int m_count;
 	size_t m_size;
 };
+
+class IndirectBuffer
+{
+public:
+	IndirectBuffer();
+	~IndirectBuffer();
+
+	void Create(size_t size);
+
+	void SetData(size_t size, const void* data); // orphans the previous contents
+
+	void Bind() const;
+	void UnBind() const;
+
+	size_t GetSize() const { return m_size; }
+
+private:
+	unsigned int m_id;
+	size_t m_size;
+};
+
+class StorageBuffer
+{
+public:
+	StorageBuffer();
+	~StorageBuffer();
+
+	void Create(size_t size, const void* data = nullptr);
+
+	void SetData(size_t offset, size_t size, const void* data);
+	void Orphan(); // new storage for the next writes, the draws in flight keep reading the old one
+
+	void Bind(unsigned int binding) const; // bind to an indexed binding point of the shaders
+	void UnBind(unsigned int binding) const;
+
+	size_t GetSize() const { return m_size; }
+
+private:
+	unsigned int m_id;
+	size_t m_size;
+};
+
+class UniformBuffer
+{
+public:
+	UniformBuffer();
+	~UniformBuffer();
+
+	void Create(size_t size, const void* data = nullptr);
+
+	void SetData(size_t offset, size_t size, const void* data);
+
+	void Bind(unsigned int binding) const; // bind to a uniform block binding point
+	void UnBind(unsigned int binding) const;
+
+	size_t GetSize() const { return m_size; }
+
+private:
+	unsigned int m_id;
+	size_t m_size;
+};
+
+// PersistentRing of pixels, the texture uploads read from it so the copy to the texture happens on the
+// gpu timeline instead of stalling glTexSubImage2D
+
+class PixelUnpackBuffer
+{
+public:
+	PixelUnpackBuffer();
+	~PixelUnpackBuffer();
+
+	void Create(size_t regionSize, unsigned int regionsCount);
+
+	void* LockRegion() { return m_ring.LockRegion(); }
+	void UnlockRegion() { m_ring.UnlockRegion(); } // after the uploads that read the region have been issued
+
+	void Bind() const; // while bound the pixel pointers of the texture uploads are offsets into the buffer
+	void UnBind() const;
+
+	size_t GetRegionSize() const { return m_ring.GetRegionSize(); }
+	size_t GetRegionOffset() const { return m_ring.GetRegionOffset(); }
+
+private:
+	unsigned int m_id;
+	PersistentRing m_ring;
+};
\ No newline at end of file
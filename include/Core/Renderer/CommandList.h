@@ -0,0 +1,83 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include "Renderer.h"
+
+struct QuadCommand
+{
+	const Texture* texture;
+	glm::vec2 position; // center of the quad
+	glm::vec2 size;
+	float rotation;
+	glm::vec4 textureRect;
+	glm::vec4 color;
+};
+
+struct LineCommand
+{
+	glm::vec2 p1, p2;
+	float width;
+	glm::vec4 color;
+	bool rectSide = false; // of a recorded DrawRect, starts half a width before p1 when replayed as triangles
+};
+
+enum class CommandPipeline
+{
+	QUADS,
+	LINES
+};
+
+// run of consecutive quads or lines recorded with the same state
+
+struct CommandListRun
+{
+	CommandPipeline pipeline;
+	int layer;
+	BlendMode blendMode;
+	uint32_t first;
+	uint32_t count;
+};
+
+// recording context that can be filled from any thread (one list per thread), the main thread
+// submits the lists with Renderer::Submit in the order it chooses, which keeps the result deterministic
+// a list starts at layer 0 without blending and with 1 pixel lines, whatever the state of the renderer is
+
+class CommandList
+{
+public:
+	CommandList();
+
+	void Clear(); // keeps the memory for the next frame
+
+	void SetLayer(int layer) { m_layer = layer; }
+	void SetBlendMode(BlendMode blendMode) { m_blendMode = blendMode; }
+	void SetLineWidth(float width) { m_lineWidth = width; }
+
+	void DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	void DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPosition, const glm::vec2& srcSize, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	void DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPosition, const glm::vec2& srcSize, float radians, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	void DrawTexture(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	void DrawTexture(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	void DrawSprites(const SpriteInstance* sprites, size_t count);
+
+	void DrawLine(const glm::vec2& p1, const glm::vec2& p2, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	void DrawRect(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	const std::vector<CommandListRun>& GetRuns() const { return m_runs; }
+	const std::vector<QuadCommand>& GetQuads() const { return m_quads; }
+	const std::vector<LineCommand>& GetLines() const { return m_lines; }
+
+private:
+	void AddToRun(CommandPipeline pipeline, uint32_t index);
+
+private:
+	std::vector<CommandListRun> m_runs;
+	std::vector<QuadCommand> m_quads;
+	std::vector<LineCommand> m_lines;
+
+	int m_layer;
+	BlendMode m_blendMode;
+	float m_lineWidth;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct GpuTiming
+{
+	static const int HISTORY = 120; // frames in the rolling average and maximum
+
+	std::string label;
+	float lastMs = 0.0f; // sum of the scopes with this label in the last frame read back
+	float averageMs = 0.0f;
+	float maxMs = 0.0f;
+	int calls = 0; // scopes with this label in the last frame read back
+
+	float history[HISTORY] = {};
+	int historyIndex = 0;
+	int historyCount = 0;
+};
+
+// gpu timings from timestamp queries, the queries of a frame are read back a few frames later
+// (when they are already available) so the cpu never waits for the gpu, scopes can be nested
+
+class GpuProfiler
+{
+public:
+	GpuProfiler();
+	~GpuProfiler();
+
+	void Init(int framesLatency = 4);
+	void Destroy();
+
+	void SetEnabled(bool enabled) { m_enabled = enabled; }
+	bool IsEnabled() const { return m_enabled; }
+
+	void BeginFrame(); // reads back the oldest frame of the ring and opens the "Frame" scope
+	void EndFrame();
+
+	void Begin(const char* label); // label must outlive the frame (a literal)
+	void End();
+
+	const std::vector<GpuTiming>& GetTimings() const { return m_timings; }
+	int GetDroppedFrames() const { return m_droppedFrames; } // frames whose queries were not ready in time
+
+	void DrawPanel(bool* open = nullptr);
+
+private:
+	struct Scope
+	{
+		int timing;
+		int beginQuery;
+		int endQuery;
+	};
+
+	struct Frame
+	{
+		std::vector<unsigned int> queries;
+		int queriesUsed = 0;
+		std::vector<Scope> scopes;
+	};
+
+	int GetTimingIndex(const char* label);
+	int NextQuery();
+	void ReadBack(Frame& frame);
+
+private:
+	bool m_enabled;
+	bool m_inFrame;
+
+	std::vector<Frame> m_frames;
+	int m_frameIndex;
+
+	std::vector<int> m_openScopes; // scope indices of the current frame
+	std::vector<GpuTiming> m_timings;
+	std::vector<const char*> m_labels; // label pointers of the timings for the quick lookup
+	int m_droppedFrames;
+};
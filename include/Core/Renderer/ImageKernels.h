@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// rgba8 pixel kernels of the texture import path (sse2 / ssse3 / avx2 with a scalar fallback), every
+// instruction set gives the same bytes as the scalar versions
+
+class ImageKernels
+{
+public:
+	static void FlipVertical(unsigned char* pixels, size_t rowSize, int height);
+	static void PremultiplyAlpha(unsigned char* rgba, size_t count); // count in pixels, color * alpha / 255 rounded
+	static void ExpandRGBToRGBA(const unsigned char* rgb, size_t count, unsigned char* rgba); // alpha 255
+	static void Swizzle(unsigned char* rgba, size_t count, const int order[4]); // in place, channel c becomes channel order[c] ({ 2, 1, 0, 3 } is bgra <-> rgba)
+
+	// next level of a mip chain, max(width / 2, 1) x max(height / 2, 1) pixels with the last row / column
+	// repeated on odd sizes, srgb averages the color in linear light (the alpha is always linear)
+
+	static void Downsample2x2(const unsigned char* src, int width, int height, unsigned char* dst, bool srgb = true);
+
+	// stb_image decode to rgba8 with the rows bottom to top (the layout of the textures), channels is what
+	// the file has, the pixels are freed with stbi_image_free (the vertical flip of stb has to stay off)
+
+	static unsigned char* LoadRGBA(const std::string& path, int* width, int* height, int* channels);
+
+	static const char* GetInstructionSet();
+
+	// the reference the simd paths are checked and benchmarked against
+
+	class Scalar
+	{
+	public:
+		static void FlipVertical(unsigned char* pixels, size_t rowSize, int height);
+		static void PremultiplyAlpha(unsigned char* rgba, size_t count);
+		static void ExpandRGBToRGBA(const unsigned char* rgb, size_t count, unsigned char* rgba);
+		static void Swizzle(unsigned char* rgba, size_t count, const int order[4]);
+		static void Downsample2x2(const unsigned char* src, int width, int height, unsigned char* dst, bool srgb = true);
+
+	private:
+		Scalar() {}
+		~Scalar() {}
+	};
+
+private:
+	ImageKernels() {}
+	~ImageKernels() {}
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+struct RenderStateStats
+{
+	int calls = 0; // state changes sent to gl
+	int elided = 0; // state changes skipped because gl already had that state
+	int uniformsElided = 0; // uniform uploads with the value the program already had
+};
+
+// cache of the gl bindings and fixed function state, every bind goes through here so the calls
+// that would not change anything are skipped
+
+class RenderState
+{
+public:
+	static void UseProgram(unsigned int program);
+	static void BindVertexArray(unsigned int vertexArray);
+	static void BindBuffer(unsigned int target, unsigned int buffer); // the element array buffer is tracked per vertex array
+	static void BindBufferBase(unsigned int target, unsigned int binding, unsigned int buffer);
+	static void BindTexture(unsigned int target, unsigned int texture); // on the active unit
+	static void BindTextureUnit(unsigned int unit, unsigned int target, unsigned int texture); // the active unit only changes when the bind is not elided
+	static void BindFramebuffer(unsigned int framebuffer);
+	static void SetBlend(bool enabled, unsigned int srcFactor = 0, unsigned int dstFactor = 0);
+	static void SetViewport(int x, int y, int width, int height);
+
+	// deleting an object resets the bindings that used it to 0, like gl does
+
+	static void ForgetProgram(unsigned int program);
+	static void ForgetVertexArray(unsigned int vertexArray);
+	static void ForgetBuffer(unsigned int buffer);
+	static void ForgetTexture(unsigned int texture);
+	static void ForgetFramebuffer(unsigned int framebuffer);
+
+	// the state was changed behind the cache (other libraries), the next calls always reach gl
+
+	static void Invalidate();
+
+	static void CountElidedUniform();
+	static const RenderStateStats& GetStats();
+	static void ResetStats();
+
+private:
+	RenderState() {}
+	~RenderState() {}
+};
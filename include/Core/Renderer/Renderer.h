@@ -1,25 +1,161 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <vector>
+#include <string>
 #include "Texture.h"
+#include "TextureRegion.h"
 #include "Shader.h"
 #include "Buffer.h"
 #include "VertexArray.h"
+#include "../OrthoCamera.h"
+
+enum class QuadRenderMode
+{
+	BATCHED, // four vertices per quad transformed on the cpu
+	INSTANCED, // one instance record per quad expanded by the vertex shader
+	VERTEX_PULLING // records in a storage buffer read from gl_VertexID, no index buffer and the batches grow instead of flushing
+};
+
+enum class TextureBindingMode
+{
+	SLOTS, // textures bound to texture units, a batch breaks when the units run out
+	BINDLESS, // bindless handles in a storage buffer, falls back to ARRAY without GL_ARB_bindless_texture
+	ARRAY // textures copied into the layers of texture arrays grouped by size
+};
+
+enum class LineRenderMode
+{
+	TRIANGLES, // segments as quads of the quad batch, any width and no draw call of their own
+	LINES // GL_LINES with their own shader and batch, the width is limited by the driver
+};
+
+enum class BlendMode
+{
+	NONE,
+	ALPHA,
+	ADDITIVE,
+	MULTIPLY,
+	PREMULTIPLIED_ALPHA // textures loaded with premultiply
+};
+
+struct RendererSpecification
+{
+	QuadRenderMode quadMode = QuadRenderMode::BATCHED;
+	int maxQuads = 10000; // quads per batch, the initial capacity in VERTEX_PULLING mode
+	TextureBindingMode textureBinding = TextureBindingMode::SLOTS;
+	LineRenderMode lineMode = LineRenderMode::LINES; // TRIANGLES for lines wider than the driver allows and no draw call of their own
+	bool streamingBuffers = true; // write vertices directly into persistent mapped buffers (not the VERTEX_PULLING storage buffer)
+	int framesInFlight = 3; // regions of the streaming buffers the gpu may still be reading
+	bool deferred = false; // record the draws as sort keyed commands and batch them at Flush
+	bool culling = false; // skip the quads (and lines) outside the visible rect of the camera, DrawSpatialGrid always queries that rect
+	bool multiDrawIndirect = false; // draw the batches of a streaming region with one glMultiDrawElementsIndirect
+	bool gpuProfiling = true; // timestamp queries around every flush, read back a few frames late
+};
+
+// binding point of the camera uniform block, every renderer shader declares it and user shaders can too
+// (#include "include/camera.glsl" from Assets/Shaders):
+//
+// layout(std140, binding = 0) uniform Camera
+// {
+//     mat4 u_projection;
+//     mat4 u_view;
+//     mat4 u_viewProjection;
+//     vec2 u_viewportSize;
+//     float u_time; // seconds since Renderer::Init, updated at BeginFrame
+//     float u_deltaTime;
+// };
+
+constexpr unsigned int CAMERA_UNIFORM_BINDING = 0;
+
+class CommandList;
+class SpatialGrid;
+class StaticBatch;
+class GpuProfiler;
+
+struct SpriteInstance
+{
+	const TextureRegion* region;
+	glm::vec2 position; // center of the sprite
+	glm::vec2 size;
+	float rotation;
+	glm::vec4 color;
+};
+
+struct CommandQueueStats
+{
+	int commands = 0;
+	int stateChangesSubmitted = 0; // state changes if the commands were drawn in submission order
+	int stateChangesSorted = 0;
+	int stateChangesSaved = 0;
+};
+
+// counters of the frame between BeginFrame and EndFrame, the lines are also counted as quads in triangle mode
+
+struct RendererStats
+{
+	int drawCalls = 0;
+	int quads = 0;
+	int lines = 0;
+	int vertices = 0;
+	size_t bytesUploaded = 0; // vertex, instance, indirect and texture table data written for the gpu
+	int textureBinds = 0;
+	int stateCallsElided = 0; // binds and state changes skipped by the RenderState cache
+	int uniformsElided = 0;
+
+	// why the batches ended
+
+	int flushesCapacity = 0; // the batch was full
+	int flushesTextureSlots = 0; // out of texture slots or texture arrays
+	int flushesStateChange = 0; // blend mode, camera, pipeline switch or static batch
+	int flushesExplicit = 0; // Renderer::Flush
+};
+
+enum class StatsExportFormat
+{
+	CSV,
+	JSON_LINES
+};
 
 class Renderer
 {
 public:
-	static void Init();
+	static void Init(const RendererSpecification& specification = RendererSpecification());
 	static void Destroy();
 	
 	static void SetClearColor(const glm::vec4& color);
 	static void Clear();
 	static void SetViewport(int x, int y, int width, int height);
 	static void SetViewportAspectRatio(int windowWidth, int windowHeight, float targetAspectRatio);
-	static void SetLineWidth(float width);
+	static void SetLineWidth(float width); // width of DrawLine and DrawRect without an explicit width
 	
 	static void StartBatch();
 	static void Flush();
+
+	// changing the camera flushes the pending draws
+
+	static void SetCamera(const OrthoCamera& camera);
+	static const OrthoCamera& GetCamera();
+
+	// deferred mode, the layer orders the draws (the order inside a layer is only kept for the same state)
+
+	static void SetLayer(int layer);
+	static void SetBlendMode(BlendMode blendMode);
+	static const CommandQueueStats& GetCommandQueueStats();
+
+	// gpu timings, the flushes are timed inside BeginFrame / EndFrame, scopes can be nested (label must be a literal)
+
+	static void BeginFrame();
+	static void EndFrame(); // flush the draws of the frame before
+	static void BeginGpuScope(const char* label);
+	static void EndGpuScope();
+	static GpuProfiler& GetGpuProfiler();
+
+	// stats of the last frame, the export writes the average per frame of every interval
+
+	static const RendererStats& GetStats();
+	static bool StartStatsExport(const std::string& path, StatsExportFormat format = StatsExportFormat::CSV, float intervalSeconds = 1.0f);
+	static void StopStatsExport();
 	
 	static void DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
 	static void DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
@@ -27,9 +163,37 @@ public:
 	static void DrawTexture(const Texture* texture, const glm::vec2& position, float radians, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
 	static void DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
 	static void DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPposition, const glm::vec2& srcSize, float radians, const glm::vec4& color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+	static void DrawTexture(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	static void DrawTexture(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	static void DrawSprites(const SpriteInstance* sprites, size_t count);
+	static void DrawSprites(const std::vector<SpriteInstance>& sprites) { DrawSprites(sprites.data(), sprites.size()); }
+	static void DrawSpatialGrid(const SpatialGrid& grid); // only the sprites in the visible rect of the camera
+
+	// retained sprites, flushes the pending draws and uploads the sprites changed since the last draw
+
+	static void DrawStaticBatch(StaticBatch& batch);
+
+	// command lists recorded on other threads, submitted from the render thread in a fixed order
+
+	static void Submit(const CommandList& commandList);
 	
 	static void DrawLine(const glm::vec2& p1, const glm::vec2& p2, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	static void DrawLine(const glm::vec2& p1, const glm::vec2& p2, float width, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	// the outline is centered on the edges of the rect, with LineRenderMode::TRIANGLES it covers the rect
+	// grown by width / 2 on every side (the corners are filled)
+
 	static void DrawRect(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	static void DrawRect(const glm::vec2& position, const glm::vec2& size, float width, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	// mitred joins (beveled past the mitre limit) in the batched quad mode, square joins in the other modes
+
+	static void DrawPolyline(const glm::vec2* points, size_t count, float width, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f }, bool closed = false);
+	static void DrawPolyline(const std::vector<glm::vec2>& points, float width, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f }, bool closed = false) { DrawPolyline(points.data(), points.size(), width, color, closed); }
+
+private:
+	static void UploadStaticBatch(StaticBatch& batch);
 
 private:
 	Renderer() {}
@@ -1,8 +1,74 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include <unordered_map>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+// fnv-1a, constexpr so the names passed as literals are hashed at compile time
+
+constexpr uint32_t HashUniformName(std::string_view name)
+{
+	uint32_t hash = 2166136261u;
+
+	for (char c : name)
+	{
+		hash ^= (uint8_t)c;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+struct UniformName
+{
+	constexpr UniformName(const char* name) : name(name), hash(HashUniformName(name)) {}
+	UniformName(const std::string& name) : name(name), hash(HashUniformName(name)) {}
+
+	std::string_view name;
+	uint32_t hash;
+};
+
+// index into the reflected uniforms of a shader, valid until the shader is loaded again
+
+struct UniformHandle
+{
+	int index = -1;
+
+	bool IsValid() const { return index != -1; }
+};
+
+struct ShaderUniform
+{
+	uint32_t hash;
+	std::string name; // arrays without the [0]
+	int location;
+	unsigned int type;
+	int count; // array size, 1 otherwise
+	std::vector<unsigned char> value; // last value uploaded, the setters skip the upload when it does not change
+};
+
+struct ShaderUniformBlock
+{
+	std::string name;
+	int binding;
+	int size;
+};
+
+struct ShaderCacheStats
+{
+	int hits = 0;
+	int misses = 0;
+	int rejected = 0; // binaries the driver refused or with a broken header, counted as misses too
+};
+
+// permutation defines, "NAME" or "NAME VALUE", inserted after the #version line of both stages
+
+using ShaderDefines = std::vector<std::string>;
+
+struct ShaderCompile;
 
 class Shader
 {
@@ -10,26 +76,64 @@ public:
 	Shader();
 	Shader(const Shader&) = delete;
 	Shader(Shader&& other) noexcept;
-	Shader(const std::string& path);
+	Shader(const std::string& path, const ShaderDefines& defines = {});
 	~Shader();
 
 	unsigned int GetId() const { return m_id; }
 	const std::string& GetPath() const { return m_path; }
+	const ShaderDefines& GetDefines() const { return m_defines; }
+
+	// the file is split by "#type vertex" / "#type fragment", #include "file" pastes a file (relative
+	// to the including one) once per stage
+
+	void Load(const std::string& path, const ShaderDefines& defines = {});
+
+	// submits the compile and link and returns, with GL_KHR_parallel_shader_compile the driver compiles
+	// on its own threads, load all the shaders first and then poll IsReady or call Wait (Bind waits too)
+
+	void LoadAsync(const std::string& path, const ShaderDefines& defines = {});
+	bool IsReady() const;
+	void Wait() const;
 
-	void Load(const std::string& path);
+	// linked programs are saved to this directory and loaded back when the sources and the driver
+	// are the same, empty (the default) disables the cache
+
+	static void SetBinaryCacheDirectory(const std::string& directory);
+	static const ShaderCacheStats& GetCacheStats();
 
 	void Bind() const;
 	void UnBind() const;
 
-	void SetUniformMat4(const std::string& name, const glm::mat4& mat);
-	void SetUniform1iv(const std::string& name, int count, const int* data);
-	void SetUniform1i(const std::string& name, int data);
-	void SetUniform1f(const std::string& name, float data);
-	void SetUniformVec2(const std::string& name, const glm::vec2& data);
-	void SetUniformVec3(const std::string& name, const glm::vec3& data);
-	void SetUniformVec4(const std::string& name, const glm::vec4& data);
-	void SetUniformVec2v(const std::string& name, int count, const glm::vec2* data);
-	void SetUniformVec3v(const std::string& name, int count, const glm::vec3* data);
+	// active uniforms and blocks enumerated at link time, the uniforms the compiler removed are not here
+
+	const std::vector<ShaderUniform>& GetUniforms() const { return m_uniforms; }
+	const std::vector<ShaderUniformBlock>& GetUniformBlocks() const { return m_uniformBlocks; }
+
+	UniformHandle GetUniformHandle(UniformName name); // warns once when the uniform is not active
+	bool HasUniform(UniformName name) const;
+	bool HasUniformBlock(std::string_view name) const;
+
+	// resolve the handles once and use them on the hot path, the names are looked up in the table every call
+
+	void SetUniformMat4(UniformHandle handle, const glm::mat4& mat);
+	void SetUniform1iv(UniformHandle handle, int count, const int* data);
+	void SetUniform1i(UniformHandle handle, int data);
+	void SetUniform1f(UniformHandle handle, float data);
+	void SetUniformVec2(UniformHandle handle, const glm::vec2& data);
+	void SetUniformVec3(UniformHandle handle, const glm::vec3& data);
+	void SetUniformVec4(UniformHandle handle, const glm::vec4& data);
+	void SetUniformVec2v(UniformHandle handle, int count, const glm::vec2* data);
+	void SetUniformVec3v(UniformHandle handle, int count, const glm::vec3* data);
+
+	void SetUniformMat4(UniformName name, const glm::mat4& mat) { SetUniformMat4(GetUniformHandle(name), mat); }
+	void SetUniform1iv(UniformName name, int count, const int* data) { SetUniform1iv(GetUniformHandle(name), count, data); }
+	void SetUniform1i(UniformName name, int data) { SetUniform1i(GetUniformHandle(name), data); }
+	void SetUniform1f(UniformName name, float data) { SetUniform1f(GetUniformHandle(name), data); }
+	void SetUniformVec2(UniformName name, const glm::vec2& data) { SetUniformVec2(GetUniformHandle(name), data); }
+	void SetUniformVec3(UniformName name, const glm::vec3& data) { SetUniformVec3(GetUniformHandle(name), data); }
+	void SetUniformVec4(UniformName name, const glm::vec4& data) { SetUniformVec4(GetUniformHandle(name), data); }
+	void SetUniformVec2v(UniformName name, int count, const glm::vec2* data) { SetUniformVec2v(GetUniformHandle(name), count, data); }
+	void SetUniformVec3v(UniformName name, int count, const glm::vec3* data) { SetUniformVec3v(GetUniformHandle(name), count, data); }
 
 	// operators
 
@@ -37,10 +141,20 @@ public:
 	Shader& operator=(Shader&& other) noexcept; // move operator
 
 private:
-	int GetUniformLocation(const std::string& name);
+	void Release(); // the program and a pending compile
+	void Reflect() const;
+	int FindUniform(UniformName name) const;
+	int GetLocationIfChanged(UniformHandle handle, const void* data, size_t size); // -1 when the program already has the value
 
 private:
-	unsigned int m_id;
 	std::string m_path;
-	std::unordered_map<std::string, int> m_uniformCache;
+	ShaderDefines m_defines;
+
+	// filled when the pending compile finishes, which a const Bind can trigger
+
+	mutable unsigned int m_id;
+	mutable std::vector<ShaderUniform> m_uniforms; // sorted by hash
+	mutable std::vector<ShaderUniformBlock> m_uniformBlocks;
+	mutable std::vector<uint32_t> m_missingUniforms; // names already warned about
+	mutable std::unique_ptr<ShaderCompile> m_compile; // while the compile is pending
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Shader.h"
+
+// one shader per file and set of defines, compiled the first time it is asked for and kept until Clear
+
+class ShaderLibrary
+{
+public:
+	// the compile is only submitted (Shader::LoadAsync), the first Bind waits for it, the order of the
+	// defines does not matter
+
+	static Shader* Get(const std::string& path, const ShaderDefines& defines = {});
+
+	static int GetCount();
+
+	// deletes every program, call it before the context is destroyed
+
+	static void Clear();
+
+private:
+	ShaderLibrary() {}
+	~ShaderLibrary() {}
+};
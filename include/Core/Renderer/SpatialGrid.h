@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "Renderer.h"
+#include "../Rect.h"
+
+// uniform hash grid of sprites, the renderer queries it with the visible rect of the camera so only
+// the sprites near the view are batched, static sprites are inserted once and dynamic ones are moved
+// with Update (cheap while they stay in the same cells)
+
+class SpatialGrid
+{
+public:
+	SpatialGrid(float cellSize = 256.0f);
+
+	void Clear();
+
+	uint32_t Insert(const SpriteInstance& sprite); // returns the handle of the sprite
+	void Update(uint32_t handle, const SpriteInstance& sprite);
+	void Remove(uint32_t handle);
+
+	const SpriteInstance& Get(uint32_t handle) const { return m_items[handle].sprite; }
+	size_t GetCount() const { return m_count; }
+	float GetCellSize() const { return m_cellSize; }
+
+	// sprites overlapping the rect in handle order, appended to the vectors
+
+	void Query(const Rect& rect, std::vector<uint32_t>& handles) const;
+	void Query(const Rect& rect, std::vector<SpriteInstance>& sprites) const;
+
+private:
+	struct Item
+	{
+		SpriteInstance sprite;
+		Rect bounds;
+		glm::ivec2 minCell, maxCell;
+		bool alive;
+	};
+
+	glm::ivec2 GetCell(const glm::vec2& position) const;
+	static uint64_t GetCellKey(int x, int y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+	void AddToCells(uint32_t handle);
+	void RemoveFromCells(uint32_t handle);
+
+private:
+	float m_cellSize;
+	float m_invCellSize;
+
+	std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+	std::vector<Item> m_items;
+	std::vector<uint32_t> m_freeHandles;
+	size_t m_count;
+
+	// items that span several cells are reported once per query
+
+	mutable std::vector<uint32_t> m_queryStamps;
+	mutable uint32_t m_queryStamp;
+	mutable std::vector<uint32_t> m_queryHandles; // scratch of the sprite Query
+};
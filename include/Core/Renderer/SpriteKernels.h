@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+// vertex generation kernels over structure of arrays input (sse / avx with a scalar fallback)
+// the corners are written as (x, y) pairs, corner k of sprite n at out + (4 * n + k) * stride
+// corner order: (-x, -y), (+x, -y), (+x, +y), (-x, +y)
+
+class SpriteKernels
+{
+public:
+	static void SinCos(const float* radians, size_t count, float* sin, float* cos);
+
+	static void AxisAlignedCorners(const float* centerX, const float* centerY, const float* halfWidth, const float* halfHeight, size_t count, float* out, size_t stride);
+	static void RotatedCorners(const float* centerX, const float* centerY, const float* halfWidth, const float* halfHeight, const float* sin, const float* cos, size_t count, float* out, size_t stride);
+
+	static const char* GetInstructionSet();
+
+private:
+	SpriteKernels() {}
+	~SpriteKernels() {}
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Buffer.h"
+#include "VertexArray.h"
+#include "CommandList.h"
+#include "../Rect.h"
+
+// consecutive sprites that fit in the texture slots, drawn with one call
+
+struct StaticBatchSegment
+{
+	uint32_t first;
+	uint32_t count;
+	std::vector<const Texture*> textures; // texture of each slot
+	Rect bounds;
+};
+
+// sprites recorded once and kept in gpu memory across frames (backgrounds, level geometry, ui frames),
+// drawn with Renderer::DrawStaticBatch, changing a few sprites with Set only uploads the dirty range
+
+class StaticBatch
+{
+public:
+	StaticBatch();
+
+	void Clear();
+
+	uint32_t Add(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f }); // position is the top left corner
+	uint32_t Add(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f }); // position is the center
+
+	void Set(uint32_t index, const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+	void Set(uint32_t index, const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color = { 1.0f, 1.0f, 1.0f, 1.0f });
+
+	uint32_t GetCount() const { return (uint32_t)m_sprites.size(); }
+	const std::vector<StaticBatchSegment>& GetSegments() const { return m_segments; }
+
+private:
+	void AddToSegment(uint32_t index);
+	void Resegment();
+	void MarkDirty(uint32_t first, uint32_t last);
+
+private:
+	friend class Renderer;
+
+	std::vector<QuadCommand> m_sprites;
+	std::vector<int> m_slots; // slot of each sprite inside its segment
+	std::vector<uint32_t> m_segmentIndices; // segment of each sprite
+	std::vector<StaticBatchSegment> m_segments;
+
+	// gpu side, recreated when the sprites outgrow it
+
+	std::unique_ptr<VertexBuffer> m_vb;
+	std::unique_ptr<VertexArray> m_va;
+	std::unique_ptr<IndexBuffer> m_ib;
+	uint32_t m_capacity;
+
+	// sprites to upload again (last exclusive)
+
+	uint32_t m_dirtyFirst;
+	uint32_t m_dirtyLast;
+};
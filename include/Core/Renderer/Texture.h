@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <cstdint>
 
 class Texture
 {
@@ -8,8 +10,8 @@ public:
 	Texture();
 	Texture(const Texture&) = delete; // delete copy ctor
 	Texture(Texture&& other) noexcept; // move constructor
-	Texture(int width, int height);
-	Texture(const std::string& path, bool keepData = false);
+	Texture(int width, int height, bool mipmaps = false);
+	Texture(const std::string& path, bool keepData = false, bool premultiply = false);
 	~Texture();
 
 	unsigned int GetId() const { return m_id; }
@@ -17,16 +19,45 @@ public:
 	int GetHeight() const { return m_height; }
 	const unsigned char* GetPixels() const { return m_pixels; }
 	int GetBpp() const { return m_bpp; }
+	unsigned int GetInternalFormat() const { return m_internalFormat; } // GL_RGBA8 or one of the GL_COMPRESSED_* of the baked textures
+	bool IsCompressed() const;
+	int GetLevels() const { return m_levels; } // mip levels with storage
 	const std::string& GetPath() const { return m_path; }
+	unsigned int GetRevision() const { return m_revision; }
 
-	void Create(int width, int height);
-	void Load(const std::string& path, bool keepData = false);
+	void Create(int width, int height, bool mipmaps = false); // mipmaps samples linear with a full chain, see UpdateMips
+	void Load(const std::string& path, bool keepData = false, bool premultiply = false); // .btex files go through LoadBaked, premultiply for BlendMode::PREMULTIPLIED_ALPHA (baked textures are premultiplied by TextureBaker)
+	void LoadBaked(const std::string& path, bool keepData = false); // mapped and uploaded with the mips it has, no decode (keepData only for rgba8)
 
 	void Bind() const;
 	void UnBind() const;
 	void Active(unsigned int slot = 0) const;
 
 	void SetPixels(int width, int height, const void* pixels);
+	void SetPixels(int x, int y, int width, int height, const void* pixels); // sub rectangle, x and y from the first row
+
+	// textures created with mipmaps keep a cpu copy of every level (4 / 3 of the base), SetPixels only marks
+	// the rows it changed and UpdateMips builds the mips over them in linear light like Load, the renderer
+	// calls it before the texture is sampled
+
+	bool HasPendingMips() const { return m_pendingFirstRow < m_pendingLastRow; }
+	void UpdateMips() const;
+
+	// streaming: the storage is created with the sampling of Load and every level is filled a few rows at
+	// a time, the pixels can be an offset into the bound pixel unpack buffer
+
+	void CreateStreamed(const std::string& path, int width, int height);
+	void SetRows(int y, int rows, const void* pixels, int level = 0);
+
+	// bindless
+
+	uint64_t GetBindlessHandle() const; // the handle is made resident on first use
+
+	// index the renderer assigned to this texture, valid while the generation matches
+
+	int GetRendererIndex() const { return m_rendererIndex; }
+	unsigned int GetRendererGeneration() const { return m_rendererGeneration; }
+	void SetRendererIndex(int index, unsigned int generation) const { m_rendererIndex = index; m_rendererGeneration = generation; }
 
 	// operators
 
@@ -38,5 +69,15 @@ private:
 	unsigned int m_id;
 	int m_width, m_height;
 	int m_bpp;
+	unsigned int m_internalFormat;
+	int m_levels;
 	unsigned char* m_pixels;
+	mutable unsigned int m_revision; // incremented every time the pixels change
+
+	mutable std::vector<std::vector<unsigned char>> m_levelPixels; // only the textures created with mipmaps
+	mutable int m_pendingFirstRow, m_pendingLastRow; // base level rows whose mips are outdated
+
+	mutable uint64_t m_bindlessHandle;
+	mutable int m_rendererIndex;
+	mutable unsigned int m_rendererGeneration;
 };
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include "Texture.h"
+#include "TextureRegion.h"
+
+struct TextureAtlasSpecification
+{
+	int pageWidth = 2048;
+	int pageHeight = 2048;
+	int maxPages = 4;
+	int padding = 1; // pixels around every image so the filtering does not sample the neighbours (2^n keeps the first n mips apart too)
+	bool bleed = true; // fill the padding with the edge pixels of the image instead of transparent
+	bool mipmaps = true; // linear filtering with a mip chain (built once over the added rows before a page is drawn), false samples the pages nearest without mips
+};
+
+struct AtlasPage;
+
+// packs images into a few big textures at runtime so the sprites of a scene share the texture slots of
+// a batch, the regions stay valid until Clear
+
+class TextureAtlas
+{
+public:
+	TextureAtlas(const TextureAtlasSpecification& specification = TextureAtlasSpecification());
+	TextureAtlas(const TextureAtlas&) = delete;
+	~TextureAtlas();
+
+	// rgba8 pixels with the rows bottom to top (like the loaded textures), the region has no texture
+	// when the image does not fit in any page
+
+	TextureRegion Add(int width, int height, const void* pixels);
+	TextureRegion Add(const std::string& path);
+
+	// copy of a sub rectangle of a texture loaded with keepData, srcPosition is the top left corner in pixels
+
+	TextureRegion Add(const Texture& texture, const glm::ivec2& srcPosition, const glm::ivec2& srcSize);
+
+	void Clear();
+
+	int GetPagesCount() const { return (int)m_pages.size(); }
+	const Texture* GetPage(int page) const;
+	float GetOccupancy(int page) const; // packed area (with the padding) over the area of the page
+
+	const TextureAtlasSpecification& GetSpecification() const { return m_specification; }
+
+	// operators
+
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+private:
+	TextureRegion AddPixels(int width, int height, const unsigned char* pixels, size_t stride);
+	AtlasPage* AddPage();
+
+private:
+	TextureAtlasSpecification m_specification;
+	std::vector<std::unique_ptr<AtlasPage>> m_pages;
+};
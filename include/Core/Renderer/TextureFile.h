@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "Core/MappedFile.h"
+
+// baked texture (.btex): the header, the table of the mips and the mips from the biggest to the
+// smallest, every mip aligned to 16 bytes and stored with the rows bottom to top (like the loaded textures)
+// so it can be uploaded straight from the mapped file
+
+constexpr uint32_t TEXTURE_FILE_MAGIC = 0x58455442; // "BTEX"
+constexpr uint32_t TEXTURE_FILE_VERSION = 1;
+
+enum class TextureFormat : uint32_t
+{
+	RGBA8,
+	BC1, // 4x4 blocks of 8 bytes, rgb with 1 bit alpha (GL_COMPRESSED_RGBA_S3TC_DXT1_EXT)
+	BC3 // 4x4 blocks of 16 bytes, rgb and interpolated alpha (GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+};
+
+struct TextureFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+	uint32_t reserved[2];
+};
+
+struct TextureFileMip
+{
+	uint64_t offset; // from the start of the file
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+};
+
+static_assert(sizeof(TextureFileHeader) == 32 && sizeof(TextureFileMip) == 24, "the texture file structs are written as they are");
+
+// size in bytes of one mip, the block formats round the size up to whole blocks
+
+size_t GetTextureFormatSize(TextureFormat format, int width, int height);
+bool IsCompressedFormat(TextureFormat format);
+const char* GetTextureFormatName(TextureFormat format);
+
+struct TextureMip
+{
+	int width;
+	int height;
+	std::vector<unsigned char> pixels;
+};
+
+class TextureFile
+{
+public:
+	TextureFile();
+
+	bool Open(const std::string& path); // maps the file and checks the header and the mips
+	void Close();
+
+	TextureFormat GetFormat() const { return (TextureFormat)m_header->format; }
+	int GetWidth() const { return (int)m_header->width; }
+	int GetHeight() const { return (int)m_header->height; }
+	int GetMipCount() const { return (int)m_header->mipCount; }
+	const TextureFileMip& GetMip(int level) const { return m_mips[level]; }
+	const void* GetMipData(int level) const { return m_file.GetData() + m_mips[level].offset; }
+
+	// baking, used by the tools
+
+	static std::vector<TextureMip> GenerateMips(int width, int height, const unsigned char* pixels, bool mips = true, bool srgb = true); // rgba8, box filter (ImageKernels::Downsample2x2)
+	static std::vector<TextureMip> GenerateMipLevels(int width, int height, const unsigned char* pixels, bool srgb = true); // levels 1 to the last, no copy of the base (Texture::Load and the streamer)
+	static bool Save(const std::string& path, TextureFormat format, const std::vector<TextureMip>& mips);
+
+private:
+	MappedFile m_file;
+	const TextureFileHeader* m_header;
+	const TextureFileMip* m_mips;
+};
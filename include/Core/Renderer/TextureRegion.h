@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "Texture.h"
+
+class TextureRegion
+{
+public:
+	TextureRegion();
+	TextureRegion(const Texture* texture);
+	TextureRegion(const Texture* texture, const glm::vec2& srcPosition, const glm::vec2& srcSize);
+
+	void Set(const Texture* texture, const glm::vec2& srcPosition, const glm::vec2& srcSize);
+
+	const Texture* GetTexture() const { return m_texture; }
+	const glm::vec4& GetTextureRect() const { return m_textureRect; } // normalized uv of the top left corner and uv size
+	const glm::vec2& GetSize() const { return m_size; } // size in pixels
+
+private:
+	const Texture* m_texture;
+	glm::vec4 m_textureRect;
+	glm::vec2 m_size;
+};
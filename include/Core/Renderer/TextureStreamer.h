@@ -0,0 +1,82 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+class Texture;
+
+struct TextureStreamerSpecification
+{
+	int decodeThreads = 2;
+	size_t uploadBudget = 8 * 1024 * 1024; // bytes copied to textures per frame, bigger images take several frames
+	unsigned int uploadRegions = 3; // regions of the pixel unpack ring, one per frame the gpu can be behind
+};
+
+// handle of a streamed texture, 0 is no texture
+
+struct StreamedTexture
+{
+	uint32_t id = 0;
+
+	bool IsValid() const { return id != 0; }
+};
+
+enum class StreamState
+{
+	NONE, // invalid or cancelled handle
+	QUEUED,
+	DECODING,
+	UPLOADING,
+	READY,
+	FAILED
+};
+
+struct TextureStreamerStats
+{
+	int queued = 0;
+	int decoding = 0;
+	int uploading = 0;
+	int ready = 0;
+	int failed = 0;
+	size_t bytesUploaded = 0; // by the last Update
+};
+
+// textures loaded in the background: the images are decoded (and their mips built) on a thread pool and copied to the textures
+// through a pixel unpack buffer, a few megabytes per frame, the closest to the camera first
+
+class TextureStreamer
+{
+public:
+	static void Init(const TextureStreamerSpecification& specification = TextureStreamerSpecification());
+	static void Destroy();
+
+	// position is where the texture is drawn in world space, only used to order the loads
+
+	static StreamedTexture Load(const std::string& path, const glm::vec2& position = { 0.0f, 0.0f });
+	static void SetPosition(StreamedTexture handle, const glm::vec2& position);
+
+	// stops the load, or frees the texture when it is already loaded, the handle is invalid after this
+
+	static void Cancel(StreamedTexture handle);
+
+	static StreamState GetState(StreamedTexture handle);
+	static bool IsReady(StreamedTexture handle) { return GetState(handle) == StreamState::READY; }
+
+	// the placeholder until the texture is ready (or when it failed), draw with an explicit size because
+	// the placeholder is not the size of the texture
+
+	static const Texture* Get(StreamedTexture handle);
+	static const Texture* GetPlaceholder();
+
+	// main thread, once per frame before drawing: starts the decodes and uploads the decoded images
+
+	static void Update(const glm::vec2& viewCenter);
+
+	static const TextureStreamerStats& GetStats();
+
+private:
+	TextureStreamer() {}
+	~TextureStreamer() {}
+};
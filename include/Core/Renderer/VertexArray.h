@@ -8,11 +8,14 @@ public:
 	VertexArray();
 	~VertexArray();
 
+	void Create(); // without vertex buffers
 	void Create(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	void AddVertexBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
 
 	void Bind() const;
 	void UnBind() const;
 
 private:
 	unsigned int m_id;
+	unsigned int m_attributesCount;
 };
\ No newline at end of file
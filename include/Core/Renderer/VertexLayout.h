@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+
+// packed attribute types, the shader reads them as floats in [0, 1], the values outside are clamped (a
+// color over 1 is stored as 1)
+
+struct Unorm8x4
+{
+	uint8_t x, y, z, w;
+
+	Unorm8x4() = default;
+	Unorm8x4(const glm::vec4& v) { glm::uvec4 p = glm::uvec4(glm::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); x = (uint8_t)p.x; y = (uint8_t)p.y; z = (uint8_t)p.z; w = (uint8_t)p.w; }
+};
+
+enum class VertexAttributeType
+{
+	FLOAT,
+	UNORM8, // normalized unsigned bytes
+	UINT32 // integer attribute (glVertexAttribIPointer)
+};
+
+struct VertexAttribute
+{
+	VertexAttributeType type;
+	unsigned int count;
+	size_t offset;
+	size_t size;
+};
+
+// attribute type of each member type
+
+template<typename T> struct VertexAttributeTraits;
+
+template<> struct VertexAttributeTraits<float> { static constexpr VertexAttributeType type = VertexAttributeType::FLOAT; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeTraits<glm::vec2> { static constexpr VertexAttributeType type = VertexAttributeType::FLOAT; static constexpr unsigned int count = 2; };
+template<> struct VertexAttributeTraits<glm::vec3> { static constexpr VertexAttributeType type = VertexAttributeType::FLOAT; static constexpr unsigned int count = 3; };
+template<> struct VertexAttributeTraits<glm::vec4> { static constexpr VertexAttributeType type = VertexAttributeType::FLOAT; static constexpr unsigned int count = 4; };
+template<> struct VertexAttributeTraits<uint32_t> { static constexpr VertexAttributeType type = VertexAttributeType::UINT32; static constexpr unsigned int count = 1; };
+template<> struct VertexAttributeTraits<Unorm8x4> { static constexpr VertexAttributeType type = VertexAttributeType::UNORM8; static constexpr unsigned int count = 4; };
+
+#define VERTEX_ATTRIBUTE(Vertex, member) VertexAttribute{ VertexAttributeTraits<decltype(Vertex::member)>::type, VertexAttributeTraits<decltype(Vertex::member)>::count, offsetof(Vertex, member), sizeof(Vertex::member) }
+
+// a vertex struct lists its members in shader location order with a specialization:
+//
+// template<> struct VertexLayout<MyVertex>
+// {
+//     static constexpr VertexAttribute attributes[] = { VERTEX_ATTRIBUTE(MyVertex, position), VERTEX_ATTRIBUTE(MyVertex, color) };
+// };
+
+template<typename Vertex> struct VertexLayout;
+
+// the attributes must follow each other in memory, be 4 byte aligned and cover the whole struct
+
+template<typename Vertex>
+constexpr bool IsVertexLayoutValid()
+{
+	size_t offset = 0;
+
+	for (const VertexAttribute& attribute : VertexLayout<Vertex>::attributes)
+	{
+		if (attribute.offset != offset || attribute.offset % 4 != 0)
+			return false;
+
+		offset += attribute.size;
+	}
+
+	return offset == sizeof(Vertex);
+}
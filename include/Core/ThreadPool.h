@@ -13,6 +13,7 @@ public:
 	~ThreadPool();
 
 	void PushTask(const std::function<void()>& task);
+	void Wait(); // block until every pushed task has finished
 
 private:
 	void DoWork();
@@ -24,4 +25,6 @@ private:
 	std::queue<std::function<void()>> m_tasks;
 	std::mutex m_tasksMutex;
 	std::condition_variable m_condition;
+	int m_pendingTasks; // queued or running
+	std::condition_variable m_doneCondition;
 };
\ No newline at end of file
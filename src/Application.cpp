@@ -105,9 +105,11 @@ int Application::Init(const std::string& title, int width, int height, bool full
 	style->TabRounding = 0.0f;
 	style->WindowRounding = 4.0f;
 
-	// init renderer
+	// init renderer, the linked shaders are cached between runs
 
+	Shader::SetBinaryCacheDirectory("ShaderCache");
 	Renderer::Init();
+	TextureStreamer::Init();
 
 	return 0;
 }
@@ -116,6 +118,7 @@ Application::~Application()
 {
 	// destroy the renderer
 
+	TextureStreamer::Destroy();
 	Renderer::Destroy();
 
 	// shutdown imgui
@@ -137,6 +140,13 @@ void Application::FixedUpdate(float delta)
 
 void Application::Render()
 {	
+	Renderer::BeginFrame();
+
+	// streamed textures, the closest to the view are loaded first
+
+	const Rect& view = Renderer::GetCamera().GetVisibleRect();
+	TextureStreamer::Update((view.min + view.max) * 0.5f);
+
 	// clear screen
 
 	glClearColor(0.25f, 0.25f, 0.25f, 1.0f);
@@ -153,9 +163,19 @@ void Application::Render()
 	// render imgui
 
 	ImGui::ShowDemoWindow();
+	Renderer::GetGpuProfiler().DrawPanel();
 
 	ImGui::Render();
+
+	Renderer::BeginGpuScope("ImGui");
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	Renderer::EndGpuScope();
+
+	// imgui changes the gl state behind the cache
+
+	RenderState::Invalidate();
+
+	Renderer::EndFrame();
 
 	// swap the window buffers
 
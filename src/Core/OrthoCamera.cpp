@@ -4,15 +4,59 @@
 OrthoCamera::OrthoCamera()
 {
 	m_position = {0.0f, 0.0f};
-	m_projection = glm::ortho(0.0f, 1280.0f, 720.0f, 0.0f);
+	m_zoom = 1.0f;
+	m_rotation = 0.0f;
+
+	SetSize(1280, 720);
 }
 
 void OrthoCamera::SetSize(int width, int height)
 {
+	m_size = { (float)width, (float)height };
     m_projection = glm::ortho(0.0f, (float)width, (float)height, 0.0f);
+
+	Recalculate();
+}
+
+void OrthoCamera::SetPosition(const glm::vec2& position)
+{
+	m_position = position;
+
+	Recalculate();
+}
+
+void OrthoCamera::SetZoom(float zoom)
+{
+	m_zoom = zoom;
+
+	Recalculate();
+}
+
+void OrthoCamera::SetRotation(float radians)
+{
+	m_rotation = radians;
+
+	Recalculate();
 }
 
-glm::mat4 OrthoCamera::GetView() const
+void OrthoCamera::Recalculate()
 {
-	return glm::translate(glm::mat4(1.0f), -glm::vec3(m_position, 0.0f));
-}
\ No newline at end of file
+	// the position is the top left corner of the view at zoom 1, zoom and rotation pivot around the center
+
+	glm::vec2 halfSize = m_size * 0.5f;
+	glm::vec2 center = m_position + halfSize;
+
+	m_view = glm::translate(glm::mat4(1.0f), glm::vec3(halfSize, 0.0f));
+
+	if (m_rotation != 0.0f)
+		m_view = glm::rotate(m_view, -m_rotation, { 0.0f, 0.0f, 1.0f });
+
+	m_view = glm::scale(m_view, { m_zoom, m_zoom, 1.0f });
+	m_view = glm::translate(m_view, -glm::vec3(center, 0.0f));
+
+	m_viewProjection = m_projection * m_view;
+
+	// visible area in world space
+
+	m_visibleRect = Rect::FromQuad(center, m_size / m_zoom, m_rotation);
+}
@@ -1,5 +1,6 @@
 #include "Core/Renderer/Buffer.h"
 #include <GL/glew.h>
+#include "Core/Renderer/RenderState.h"
 #include <cassert>
 
 /* VERTEX BUFFER LAYOUT */
@@ -7,29 +8,117 @@
 VertexBufferLayout::VertexBufferLayout()
 {
 	m_stride = 0;
+	m_divisor = 0;
 }
 
 template<>
 void VertexBufferLayout::AddElement<float>(unsigned int count)
 {
-	m_elements.push_back({ count, GL_FLOAT, sizeof(float)});
+	m_elements.push_back({ count, GL_FLOAT, sizeof(float), m_stride, false, false });
 	m_stride += count * sizeof(float);
 }
 
 template<>
 void VertexBufferLayout::AddElement<unsigned int>(unsigned int count)
 {
-	m_elements.push_back({ count, GL_UNSIGNED_INT, sizeof(unsigned int)});
+	m_elements.push_back({ count, GL_UNSIGNED_INT, sizeof(unsigned int), m_stride, false, false });
 	m_stride += count * sizeof(unsigned int);
 }
 
 template<>
 void VertexBufferLayout::AddElement<unsigned char>(unsigned int count)
 {
-	m_elements.push_back({ count, GL_UNSIGNED_BYTE, sizeof(unsigned char)});
+	m_elements.push_back({ count, GL_UNSIGNED_BYTE, sizeof(unsigned char), m_stride, false, false });
 	m_stride += count * sizeof(unsigned char);
 }
 
+void VertexBufferLayout::AddAttribute(const VertexAttribute& attribute)
+{
+	switch (attribute.type)
+	{
+	case VertexAttributeType::UNORM8:
+		m_elements.push_back({ attribute.count, GL_UNSIGNED_BYTE, sizeof(unsigned char), attribute.offset, true, false });
+		break;
+	case VertexAttributeType::UINT32:
+		m_elements.push_back({ attribute.count, GL_UNSIGNED_INT, sizeof(unsigned int), attribute.offset, false, true });
+		break;
+	default:
+		m_elements.push_back({ attribute.count, GL_FLOAT, sizeof(float), attribute.offset, false, false });
+		break;
+	}
+
+	m_stride = attribute.offset + attribute.size;
+}
+
+/* PERSISTENT RING */
+
+PersistentRing::PersistentRing()
+{
+	m_mappedPtr = nullptr;
+	m_regionSize = 0;
+	m_regionIndex = 0;
+}
+
+PersistentRing::~PersistentRing()
+{
+	// the owner deletes the buffer, which also unmaps it
+
+	for (void* fence : m_fences)
+		glDeleteSync((GLsync)fence);
+}
+
+void PersistentRing::Create(unsigned int target, size_t regionSize, unsigned int regionsCount)
+{
+	assert(m_mappedPtr == nullptr && regionsCount > 0);
+
+	m_regionSize = regionSize;
+	m_regionIndex = 0;
+	m_fences.assign(regionsCount, nullptr);
+
+	// immutable storage mapped once for the whole lifetime of the buffer, the cpu writes
+	// directly into it and the fences tell when the gpu is done reading a region
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glBufferStorage(target, regionSize * regionsCount, nullptr, flags);
+
+	m_mappedPtr = (unsigned char*)glMapBufferRange(target, 0, regionSize * regionsCount, flags);
+
+	assert(m_mappedPtr != nullptr);
+}
+
+void* PersistentRing::LockRegion()
+{
+	assert(m_mappedPtr != nullptr);
+
+	// wait until the gpu has finished with the commands that used this region
+
+	GLsync fence = (GLsync)m_fences[m_regionIndex];
+
+	if (fence != nullptr)
+	{
+		GLenum result = glClientWaitSync(fence, 0, 0);
+
+		while (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && result != GL_WAIT_FAILED)
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+
+		glDeleteSync(fence);
+		m_fences[m_regionIndex] = nullptr;
+	}
+
+	return m_mappedPtr + GetRegionOffset();
+}
+
+void PersistentRing::UnlockRegion()
+{
+	assert(m_mappedPtr != nullptr);
+
+	// fence the commands issued so far and move to the next region of the ring
+
+	m_fences[m_regionIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_regionIndex = (m_regionIndex + 1) % m_fences.size();
+}
+
 /* VERTEX BUFFER */
 
 VertexBuffer::VertexBuffer()
@@ -40,6 +129,9 @@ VertexBuffer::VertexBuffer()
 
 VertexBuffer::~VertexBuffer()
 {
+	// deleting the buffer also unmaps it
+
+	RenderState::ForgetBuffer(m_id);
 	glDeleteBuffers(1, &m_id);
 }
 
@@ -50,7 +142,7 @@ void VertexBuffer::Create(size_t size)
 	m_size = size;
 
 	glGenBuffers(1, &m_id);
-	glBindBuffer(GL_ARRAY_BUFFER, m_id);
+	RenderState::BindBuffer(GL_ARRAY_BUFFER, m_id);
 	glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
 }
 
@@ -61,23 +153,44 @@ void VertexBuffer::Create(size_t size, const void* data)
 	m_size = size;
 
 	glGenBuffers(1, &m_id);
-	glBindBuffer(GL_ARRAY_BUFFER, m_id);
+	RenderState::BindBuffer(GL_ARRAY_BUFFER, m_id);
 	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
+void VertexBuffer::CreateStreaming(size_t regionSize, unsigned int regionsCount)
+{
+	// assert(m_id == 0);
+
+	m_size = regionSize * regionsCount;
+
+	glGenBuffers(1, &m_id);
+	RenderState::BindBuffer(GL_ARRAY_BUFFER, m_id);
+
+	m_ring.Create(GL_ARRAY_BUFFER, regionSize, regionsCount);
+}
+
 void VertexBuffer::SetData(size_t size, const void* data)
 {
+	assert(!IsStreaming()); // streaming buffers are written through LockRegion
+
 	glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
 }
 
+void VertexBuffer::SetData(size_t offset, size_t size, const void* data)
+{
+	assert(!IsStreaming() && offset + size <= m_size);
+
+	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+}
+
 void VertexBuffer::Bind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, m_id);
+	RenderState::BindBuffer(GL_ARRAY_BUFFER, m_id);
 }
 
 void VertexBuffer::UnBind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 /* INDEX BUFFER */
@@ -91,6 +204,7 @@ IndexBuffer::IndexBuffer()
 
 IndexBuffer::~IndexBuffer()
 {
+	RenderState::ForgetBuffer(m_id);
 	glDeleteBuffers(1, &m_id);
 }
 
@@ -102,16 +216,200 @@ void IndexBuffer::Create(unsigned int count, const void* data)
 	m_size = count * sizeof(unsigned int);
 
 	glGenBuffers(1, &m_id);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
+	RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_size, data, GL_STATIC_DRAW);
 }
 
 void IndexBuffer::Bind() const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
+	RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
 }
 
 void IndexBuffer::UnBind() const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/* INDIRECT BUFFER */
+
+IndirectBuffer::IndirectBuffer()
+{
+	m_id = 0;
+	m_size = 0;
+}
+
+IndirectBuffer::~IndirectBuffer()
+{
+	RenderState::ForgetBuffer(m_id);
+	glDeleteBuffers(1, &m_id);
+}
+
+void IndirectBuffer::Create(size_t size)
+{
+	// indirect buffers can be recreated to grow them
+
+	RenderState::ForgetBuffer(m_id);
+	glDeleteBuffers(1, &m_id);
+
+	m_size = size;
+
+	glGenBuffers(1, &m_id);
+	RenderState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_id);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, size, nullptr, GL_STREAM_DRAW);
+}
+
+void IndirectBuffer::SetData(size_t size, const void* data)
+{
+	assert(size <= m_size);
+
+	// the draws of the previous submission may still read the old storage
+
+	RenderState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_id);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_size, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, data);
+}
+
+void IndirectBuffer::Bind() const
+{
+	RenderState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_id);
+}
+
+void IndirectBuffer::UnBind() const
+{
+	RenderState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/* STORAGE BUFFER */
+
+StorageBuffer::StorageBuffer()
+{
+	m_id = 0;
+	m_size = 0;
+}
+
+StorageBuffer::~StorageBuffer()
+{
+	RenderState::ForgetBuffer(m_id);
+	glDeleteBuffers(1, &m_id);
+}
+
+void StorageBuffer::Create(size_t size, const void* data)
+{
+	// storage buffers can be recreated to grow them
+
+	RenderState::ForgetBuffer(m_id);
+	glDeleteBuffers(1, &m_id);
+
+	m_size = size;
+
+	glGenBuffers(1, &m_id);
+	RenderState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+}
+
+void StorageBuffer::SetData(size_t offset, size_t size, const void* data)
+{
+	assert(offset + size <= m_size);
+
+	RenderState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, size, data);
+}
+
+void StorageBuffer::Orphan()
+{
+	RenderState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_id);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_size, nullptr, GL_DYNAMIC_DRAW);
+}
+
+void StorageBuffer::Bind(unsigned int binding) const
+{
+	RenderState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_id);
+}
+
+void StorageBuffer::UnBind(unsigned int binding) const
+{
+	RenderState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, 0);
+}
+
+/* UNIFORM BUFFER */
+
+UniformBuffer::UniformBuffer()
+{
+	m_id = 0;
+	m_size = 0;
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	RenderState::ForgetBuffer(m_id);
+	glDeleteBuffers(1, &m_id);
+}
+
+void UniformBuffer::Create(size_t size, const void* data)
+{
+	RenderState::ForgetBuffer(m_id);
+	glDeleteBuffers(1, &m_id);
+
+	m_size = size;
+
+	glGenBuffers(1, &m_id);
+	RenderState::BindBuffer(GL_UNIFORM_BUFFER, m_id);
+	glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW);
+}
+
+void UniformBuffer::SetData(size_t offset, size_t size, const void* data)
+{
+	assert(offset + size <= m_size);
+
+	RenderState::BindBuffer(GL_UNIFORM_BUFFER, m_id);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+}
+
+void UniformBuffer::Bind(unsigned int binding) const
+{
+	RenderState::BindBufferBase(GL_UNIFORM_BUFFER, binding, m_id);
+}
+
+void UniformBuffer::UnBind(unsigned int binding) const
+{
+	RenderState::BindBufferBase(GL_UNIFORM_BUFFER, binding, 0);
+}
+
+/* PIXEL UNPACK BUFFER */
+
+PixelUnpackBuffer::PixelUnpackBuffer()
+{
+	m_id = 0;
+}
+
+PixelUnpackBuffer::~PixelUnpackBuffer()
+{
+	// deleting the buffer also unmaps it
+
+	RenderState::ForgetBuffer(m_id);
+	glDeleteBuffers(1, &m_id);
+}
+
+void PixelUnpackBuffer::Create(size_t regionSize, unsigned int regionsCount)
+{
+	assert(m_id == 0);
+
+	glGenBuffers(1, &m_id);
+	RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_id);
+
+	m_ring.Create(GL_PIXEL_UNPACK_BUFFER, regionSize, regionsCount);
+
+	// unbound, the uploads from client memory would read the buffer otherwise
+
+	RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void PixelUnpackBuffer::Bind() const
+{
+	RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_id);
+}
+
+void PixelUnpackBuffer::UnBind() const
+{
+	RenderState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
@@ -0,0 +1,111 @@
+#include "Core/Renderer/CommandList.h"
+
+CommandList::CommandList()
+{
+	m_layer = 0;
+	m_blendMode = BlendMode::NONE;
+	m_lineWidth = 1.0f;
+}
+
+void CommandList::Clear()
+{
+	m_runs.clear();
+	m_quads.clear();
+	m_lines.clear();
+
+	m_layer = 0;
+	m_blendMode = BlendMode::NONE;
+	m_lineWidth = 1.0f;
+}
+
+void CommandList::AddToRun(CommandPipeline pipeline, uint32_t index)
+{
+	// extend the last run while the state does not change
+
+	if (!m_runs.empty())
+	{
+		auto& run = m_runs.back();
+
+		if (run.pipeline == pipeline && run.layer == m_layer && run.blendMode == m_blendMode)
+		{
+			run.count++;
+			return;
+		}
+	}
+
+	m_runs.push_back({ pipeline, m_layer, m_blendMode, index, 1 });
+}
+
+void CommandList::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+	if (texture == nullptr)
+		return;
+
+	DrawTexture(texture, position, size, { 0.0f, 0.0f }, { texture->GetWidth(), texture->GetHeight() }, color);
+}
+
+void CommandList::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPosition, const glm::vec2& srcSize, const glm::vec4& color)
+{
+	if (texture == nullptr)
+		return;
+
+	// the position is the top left corner
+
+	DrawTexture(TextureRegion(texture, srcPosition, srcSize), position, size, color);
+}
+
+void CommandList::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPosition, const glm::vec2& srcSize, float radians, const glm::vec4& color)
+{
+	if (texture == nullptr)
+		return;
+
+	// the position is the center of the quad
+
+	DrawTexture(TextureRegion(texture, srcPosition, srcSize), position, size, radians, color);
+}
+
+void CommandList::DrawTexture(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+	DrawTexture(region, position + size * 0.5f, size, 0.0f, color);
+}
+
+void CommandList::DrawTexture(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color)
+{
+	if (region.GetTexture() == nullptr)
+		return;
+
+	AddToRun(CommandPipeline::QUADS, (uint32_t)m_quads.size());
+
+	m_quads.push_back({ region.GetTexture(), position, size, radians, region.GetTextureRect(), color });
+}
+
+void CommandList::DrawSprites(const SpriteInstance* sprites, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		const SpriteInstance& sprite = sprites[i];
+
+		if (sprite.region != nullptr)
+			DrawTexture(*sprite.region, sprite.position, sprite.size, sprite.rotation, sprite.color);
+	}
+}
+
+void CommandList::DrawLine(const glm::vec2& p1, const glm::vec2& p2, const glm::vec4& color)
+{
+	AddToRun(CommandPipeline::LINES, (uint32_t)m_lines.size());
+
+	m_lines.push_back({ p1, p2, m_lineWidth, color });
+}
+
+void CommandList::DrawRect(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+	glm::vec2 corners[4] = { position, { position.x + size.x, position.y }, position + size, { position.x, position.y + size.y } };
+
+	// the sides are extended at replay, only the triangle lines need it (like Renderer::DrawRect)
+
+	for (int i = 0; i < 4; i++)
+	{
+		DrawLine(corners[i], corners[(i + 1) % 4], color);
+		m_lines.back().rectSide = true;
+	}
+}
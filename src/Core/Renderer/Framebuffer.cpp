@@ -1,5 +1,6 @@
 #include "Core/Renderer/Framebuffer.h"
 #include <GL/glew.h>
+#include "Core/Renderer/RenderState.h"
 #include <cassert>
 
 /* FRAMEBUFFER */
@@ -21,22 +22,27 @@ Framebuffer::Framebuffer(const FramebufferSpecification& specification)
 
 Framebuffer::~Framebuffer()
 {
+	RenderState::ForgetFramebuffer(m_id);
 	glDeleteFramebuffers(1, &m_id);
 
     for (auto& colorAttachment : m_colorAttachments)
+    {
+        RenderState::ForgetTexture(colorAttachment.id);
         glDeleteTextures(1, &colorAttachment.id);
+    }
 
+	RenderState::ForgetTexture(m_depthAttachment.id);
 	glDeleteTextures(1, &m_depthAttachment.id);
 }
 
 void Framebuffer::Bind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+    RenderState::BindFramebuffer(m_id);
 }
 
 void Framebuffer::UnBind() const
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    RenderState::BindFramebuffer(0);
 }
 
 unsigned int Framebuffer::GetColorAttachment(unsigned int index) const
@@ -53,7 +59,7 @@ void Framebuffer::AttachColorBuffer(int internalFormat, int format)
     int colorAttachmentIndex = m_colorAttachments.size();
 
     glGenTextures(1, &colorAttachmentId);
-    glBindTexture(GL_TEXTURE_2D, colorAttachmentId);
+    RenderState::BindTexture(GL_TEXTURE_2D, colorAttachmentId);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -70,7 +76,7 @@ void Framebuffer::AttachColorBuffer(int internalFormat, int format)
 void Framebuffer::AttachDepthBuffer()
 {
     glGenTextures(1, &m_depthAttachment.id);
-    glBindTexture(GL_TEXTURE_2D, m_depthAttachment.id);
+    RenderState::BindTexture(GL_TEXTURE_2D, m_depthAttachment.id);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -87,7 +93,7 @@ void Framebuffer::Create()
     // create framebuffer
 
     glGenFramebuffers(1, &m_id);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+    RenderState::BindFramebuffer(m_id);
 
     // add attachments
 
@@ -144,18 +150,23 @@ void Framebuffer::Create()
 
     // unbind the framebuffer
  
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    RenderState::BindFramebuffer(0);
 }
 
 void Framebuffer::Resize(int width, int height)
 {
     // delete the framebuffer and color and depth attachments
 
+    RenderState::ForgetFramebuffer(m_id);
     glDeleteFramebuffers(1, &m_id);
 
     for (auto& colorAttachment : m_colorAttachments)
+    {
+        RenderState::ForgetTexture(colorAttachment.id);
         glDeleteTextures(1, &colorAttachment.id);
+    }
 
+    RenderState::ForgetTexture(m_depthAttachment.id);
     glDeleteTextures(1, &m_depthAttachment.id);
 
     m_colorAttachments.clear();
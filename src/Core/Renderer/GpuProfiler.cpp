@@ -0,0 +1,241 @@
+#include "Core/Renderer/GpuProfiler.h"
+#include <GL/glew.h>
+#include <imgui/imgui.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+GpuProfiler::GpuProfiler()
+{
+	m_enabled = false;
+	m_inFrame = false;
+	m_frameIndex = 0;
+	m_droppedFrames = 0;
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	Destroy();
+}
+
+void GpuProfiler::Init(int framesLatency)
+{
+	Destroy();
+
+	m_frames.resize(std::max(framesLatency, 2));
+	m_frameIndex = 0;
+	m_enabled = true;
+}
+
+void GpuProfiler::Destroy()
+{
+	for (auto& frame : m_frames)
+	{
+		if (!frame.queries.empty())
+			glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+	}
+
+	m_frames.clear();
+	m_openScopes.clear();
+	m_enabled = false;
+	m_inFrame = false;
+}
+
+int GpuProfiler::GetTimingIndex(const char* label)
+{
+	// labels are literals, compare the pointers first
+
+	for (int i = 0; i < (int)m_labels.size(); i++)
+	{
+		if (m_labels[i] == label)
+			return i;
+	}
+
+	for (int i = 0; i < (int)m_timings.size(); i++)
+	{
+		if (m_timings[i].label == label)
+			return i;
+	}
+
+	m_timings.emplace_back();
+	m_timings.back().label = label;
+	m_labels.push_back(label);
+
+	return (int)m_timings.size() - 1;
+}
+
+int GpuProfiler::NextQuery()
+{
+	Frame& frame = m_frames[m_frameIndex];
+
+	if (frame.queriesUsed == (int)frame.queries.size())
+	{
+		unsigned int query;
+		glGenQueries(1, &query);
+		frame.queries.push_back(query);
+	}
+
+	return frame.queriesUsed++;
+}
+
+void GpuProfiler::ReadBack(Frame& frame)
+{
+	if (frame.scopes.empty())
+		return;
+
+	// the timestamps complete in order, the last one being ready means the whole frame is
+
+	GLint available = 0;
+	glGetQueryObjectiv(frame.queries[frame.queriesUsed - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	if (!available)
+	{
+		m_droppedFrames++;
+		return;
+	}
+
+	for (auto& timing : m_timings)
+	{
+		timing.lastMs = 0.0f;
+		timing.calls = 0;
+	}
+
+	for (const auto& scope : frame.scopes)
+	{
+		if (scope.endQuery < 0)
+			continue;
+
+		GLuint64 begin, end;
+		glGetQueryObjectui64v(frame.queries[scope.beginQuery], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.queries[scope.endQuery], GL_QUERY_RESULT, &end);
+
+		auto& timing = m_timings[scope.timing];
+		timing.lastMs += (float)((double)(end - begin) * 1e-6);
+		timing.calls++;
+	}
+
+	// rolling average and maximum
+
+	for (auto& timing : m_timings)
+	{
+		timing.history[timing.historyIndex] = timing.lastMs;
+		timing.historyIndex = (timing.historyIndex + 1) % GpuTiming::HISTORY;
+		timing.historyCount = std::min(timing.historyCount + 1, GpuTiming::HISTORY);
+
+		float sum = 0.0f;
+		float max = 0.0f;
+
+		for (int i = 0; i < timing.historyCount; i++)
+		{
+			sum += timing.history[i];
+			max = std::max(max, timing.history[i]);
+		}
+
+		timing.averageMs = sum / timing.historyCount;
+		timing.maxMs = max;
+	}
+}
+
+void GpuProfiler::BeginFrame()
+{
+	if (!m_enabled || m_inFrame)
+		return;
+
+	// this slot was used framesLatency frames ago
+
+	Frame& frame = m_frames[m_frameIndex];
+
+	ReadBack(frame);
+
+	frame.queriesUsed = 0;
+	frame.scopes.clear();
+
+	m_inFrame = true;
+
+	Begin("Frame");
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (!m_enabled || !m_inFrame)
+		return;
+
+	if (m_openScopes.size() > 1)
+		std::cout << "[WARNING] GPU profiler scopes left open at the end of the frame" << std::endl;
+
+	while (!m_openScopes.empty())
+		End();
+
+	m_inFrame = false;
+	m_frameIndex = (m_frameIndex + 1) % m_frames.size();
+}
+
+void GpuProfiler::Begin(const char* label)
+{
+	if (!m_enabled || !m_inFrame)
+		return;
+
+	Frame& frame = m_frames[m_frameIndex];
+
+	int query = NextQuery();
+	glQueryCounter(frame.queries[query], GL_TIMESTAMP);
+
+	m_openScopes.push_back((int)frame.scopes.size());
+	frame.scopes.push_back({ GetTimingIndex(label), query, -1 });
+}
+
+void GpuProfiler::End()
+{
+	if (!m_enabled || !m_inFrame || m_openScopes.empty())
+		return;
+
+	Frame& frame = m_frames[m_frameIndex];
+
+	int query = NextQuery();
+	glQueryCounter(frame.queries[query], GL_TIMESTAMP);
+
+	frame.scopes[m_openScopes.back()].endQuery = query;
+	m_openScopes.pop_back();
+}
+
+void GpuProfiler::DrawPanel(bool* open)
+{
+	if (!ImGui::Begin("GPU Timings", open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (!m_enabled)
+	{
+		ImGui::TextDisabled("GPU profiling disabled");
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("%d frames late, %d dropped", (int)m_frames.size(), m_droppedFrames);
+
+	if (ImGui::BeginTable("timings", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+	{
+		ImGui::TableSetupColumn("Label");
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableSetupColumn("Last (ms)");
+		ImGui::TableSetupColumn("Avg (ms)");
+		ImGui::TableSetupColumn("Max (ms)");
+		ImGui::TableHeadersRow();
+
+		for (const auto& timing : m_timings)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(timing.label.c_str());
+			ImGui::TableNextColumn(); ImGui::Text("%d", timing.calls);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", timing.lastMs);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", timing.averageMs);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", timing.maxMs);
+		}
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,508 @@
+#include "Core/Renderer/ImageKernels.h"
+#include <stb_image/stb_image.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+#define IMAGE_KERNELS_AVX2
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define IMAGE_KERNELS_SSSE3
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_KERNELS_SSE
+#endif
+
+#if defined(IMAGE_KERNELS_AVX2)
+#include <immintrin.h>
+#elif defined(IMAGE_KERNELS_SSSE3)
+#include <tmmintrin.h>
+#elif defined(IMAGE_KERNELS_SSE)
+#include <emmintrin.h>
+#endif
+
+/* srgb tables */
+
+// 16 bit linear is finer than 8 bit srgb everywhere (the steepest step of the curve is under 0.05 of a
+// code), so a flat color goes through the tables unchanged
+
+struct SRGBTables
+{
+	uint32_t toLinear[256]; // 0 - 65535
+	uint8_t toSRGB[65536];
+
+	SRGBTables()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			double c = i / 255.0;
+			double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+
+			toLinear[i] = (uint32_t)std::lround(linear * 65535.0);
+		}
+
+		for (int i = 0; i < 65536; i++)
+		{
+			double linear = i / 65535.0;
+			double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+
+			toSRGB[i] = (uint8_t)std::lround(std::clamp(c, 0.0, 1.0) * 255.0);
+		}
+	}
+};
+
+static const SRGBTables& GetSRGBTables()
+{
+	static SRGBTables tables;
+
+	return tables;
+}
+
+/* scalar */
+
+static void SwapBytesScalar(unsigned char* a, unsigned char* b, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+		std::swap(a[i], b[i]);
+}
+
+static inline unsigned char MultiplyAlpha(unsigned int c, unsigned int a)
+{
+	// c * a / 255 rounded, exact for every pair of bytes
+
+	unsigned int t = c * a + 128;
+
+	return (unsigned char)((t + (t >> 8)) >> 8);
+}
+
+static void PremultiplyAlphaScalar(unsigned char* rgba, size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		unsigned char* p = rgba + i * 4;
+
+		p[0] = MultiplyAlpha(p[0], p[3]);
+		p[1] = MultiplyAlpha(p[1], p[3]);
+		p[2] = MultiplyAlpha(p[2], p[3]);
+	}
+}
+
+static void ExpandRGBToRGBAScalar(const unsigned char* rgb, size_t begin, size_t end, unsigned char* rgba)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		rgba[i * 4 + 0] = rgb[i * 3 + 0];
+		rgba[i * 4 + 1] = rgb[i * 3 + 1];
+		rgba[i * 4 + 2] = rgb[i * 3 + 2];
+		rgba[i * 4 + 3] = 255;
+	}
+}
+
+// gray or gray and alpha images (LoadRGBA)
+
+static void ExpandGrayToRGBAScalar(const unsigned char* gray, size_t count, bool alpha, unsigned char* rgba)
+{
+	int channels = alpha ? 2 : 1;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		unsigned char value = gray[i * channels];
+
+		rgba[i * 4 + 0] = value;
+		rgba[i * 4 + 1] = value;
+		rgba[i * 4 + 2] = value;
+		rgba[i * 4 + 3] = alpha ? gray[i * channels + 1] : 255;
+	}
+}
+
+static void SwizzleScalar(unsigned char* rgba, size_t begin, size_t end, const int order[4])
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		unsigned char* p = rgba + i * 4;
+		unsigned char src[4] = { p[0], p[1], p[2], p[3] };
+
+		for (int c = 0; c < 4; c++)
+			p[c] = src[order[c]];
+	}
+}
+
+// pixels begin to end of a row of the next level, row0 and row1 are the two source rows
+
+static void DownsampleRowScalar(const unsigned char* row0, const unsigned char* row1, int srcWidth, unsigned char* dst, int begin, int end, bool srgb)
+{
+	const SRGBTables& tables = GetSRGBTables();
+
+	for (int x = begin; x < end; x++)
+	{
+		int x0 = std::min(2 * x, srcWidth - 1) * 4;
+		int x1 = std::min(2 * x + 1, srcWidth - 1) * 4;
+
+		for (int c = 0; c < 4; c++)
+		{
+			if (srgb && c < 3)
+			{
+				uint32_t sum = tables.toLinear[row0[x0 + c]] + tables.toLinear[row0[x1 + c]] + tables.toLinear[row1[x0 + c]] + tables.toLinear[row1[x1 + c]];
+				dst[x * 4 + c] = tables.toSRGB[(sum + 2) >> 2];
+			}
+			else
+				dst[x * 4 + c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+		}
+	}
+}
+
+/* simd */
+
+#if defined(IMAGE_KERNELS_SSE)
+
+// the 2x2 sums of 4 pixels of the next level from 8 pixels of each source row, 16 bit lanes (out0, out1) (out2, out3)
+
+static inline void BoxSums4(__m128i a0, __m128i a1, __m128i b0, __m128i b1, __m128i* s0, __m128i* s1)
+{
+	__m128i zero = _mm_setzero_si128();
+
+	__m128i v01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+	__m128i v23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+	__m128i v45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+	__m128i v67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+	*s0 = _mm_add_epi16(_mm_unpacklo_epi64(v01, v23), _mm_unpackhi_epi64(v01, v23));
+	*s1 = _mm_add_epi16(_mm_unpacklo_epi64(v45, v67), _mm_unpackhi_epi64(v45, v67));
+}
+
+static inline __m128i PremultiplyAlpha4(__m128i pixels16)
+{
+	// alpha of each pixel in its 4 lanes, 255 in the alpha lane so the alpha stays the same
+
+	__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm_or_si128(_mm_and_si128(alpha, _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1)), _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0));
+
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(pixels16, alpha), _mm_set1_epi16(128));
+
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+#endif
+
+#if defined(IMAGE_KERNELS_AVX2)
+
+static inline __m256i PremultiplyAlpha8(__m256i pixels16)
+{
+	__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels16, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm256_or_si256(_mm256_and_si256(alpha, _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1)),
+		_mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0));
+
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(pixels16, alpha), _mm256_set1_epi16(128));
+
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+#endif
+
+static void DownsampleRow(const unsigned char* row0, const unsigned char* row1, int srcWidth, unsigned char* dst, int dstWidth, bool srgb)
+{
+	int x = 0;
+
+	// the vector paths read the pixels 2x and 2x + 1, both in the row unless the source is 1 pixel wide, the
+	// srgb path is bound by its table loads (avx2 gathers and vector sums around scalar loads were both slower)
+
+	if (srgb || srcWidth < 2)
+	{
+		DownsampleRowScalar(row0, row1, srcWidth, dst, 0, dstWidth, srgb);
+		return;
+	}
+
+#if defined(IMAGE_KERNELS_AVX2)
+	for (; x + 8 <= dstWidth; x += 8)
+	{
+		__m256i zero = _mm256_setzero_si256();
+
+		__m256i a0 = _mm256_loadu_si256((const __m256i*)(row0 + x * 8));
+		__m256i a1 = _mm256_loadu_si256((const __m256i*)(row0 + x * 8 + 32));
+		__m256i b0 = _mm256_loadu_si256((const __m256i*)(row1 + x * 8));
+		__m256i b1 = _mm256_loadu_si256((const __m256i*)(row1 + x * 8 + 32));
+
+		// the unpacks work per 128 bit lane, the sums come out as (out0, out1, out2, out3) and (out4, out5, out6, out7)
+		// split between the lanes and are put back in order after the pack
+
+		__m256i vLo0 = _mm256_add_epi16(_mm256_unpacklo_epi8(a0, zero), _mm256_unpacklo_epi8(b0, zero));
+		__m256i vHi0 = _mm256_add_epi16(_mm256_unpackhi_epi8(a0, zero), _mm256_unpackhi_epi8(b0, zero));
+		__m256i vLo1 = _mm256_add_epi16(_mm256_unpacklo_epi8(a1, zero), _mm256_unpacklo_epi8(b1, zero));
+		__m256i vHi1 = _mm256_add_epi16(_mm256_unpackhi_epi8(a1, zero), _mm256_unpackhi_epi8(b1, zero));
+
+		__m256i s0 = _mm256_add_epi16(_mm256_unpacklo_epi64(vLo0, vHi0), _mm256_unpackhi_epi64(vLo0, vHi0));
+		__m256i s1 = _mm256_add_epi16(_mm256_unpacklo_epi64(vLo1, vHi1), _mm256_unpackhi_epi64(vLo1, vHi1));
+
+		s0 = _mm256_srli_epi16(_mm256_add_epi16(s0, _mm256_set1_epi16(2)), 2);
+		s1 = _mm256_srli_epi16(_mm256_add_epi16(s1, _mm256_set1_epi16(2)), 2);
+
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(s0, s1), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)(dst + x * 4), packed);
+	}
+#endif
+
+#if defined(IMAGE_KERNELS_SSE)
+	for (; x + 4 <= dstWidth; x += 4)
+	{
+		__m128i s0, s1;
+
+		BoxSums4(_mm_loadu_si128((const __m128i*)(row0 + x * 8)), _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16)),
+			_mm_loadu_si128((const __m128i*)(row1 + x * 8)), _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16)), &s0, &s1);
+
+		s0 = _mm_srli_epi16(_mm_add_epi16(s0, _mm_set1_epi16(2)), 2);
+		s1 = _mm_srli_epi16(_mm_add_epi16(s1, _mm_set1_epi16(2)), 2);
+
+		_mm_storeu_si128((__m128i*)(dst + x * 4), _mm_packus_epi16(s0, s1));
+	}
+#endif
+
+	DownsampleRowScalar(row0, row1, srcWidth, dst, x, dstWidth, false);
+}
+
+/* IMAGE KERNELS */
+
+void ImageKernels::FlipVertical(unsigned char* pixels, size_t rowSize, int height)
+{
+	for (int y = 0; y < height / 2; y++)
+	{
+		unsigned char* a = pixels + (size_t)y * rowSize;
+		unsigned char* b = pixels + (size_t)(height - 1 - y) * rowSize;
+		size_t i = 0;
+
+#if defined(IMAGE_KERNELS_AVX2)
+		for (; i + 32 <= rowSize; i += 32)
+		{
+			__m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+			__m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+
+			_mm256_storeu_si256((__m256i*)(a + i), vb);
+			_mm256_storeu_si256((__m256i*)(b + i), va);
+		}
+#endif
+
+#if defined(IMAGE_KERNELS_SSE)
+		for (; i + 16 <= rowSize; i += 16)
+		{
+			__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+			__m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+
+			_mm_storeu_si128((__m128i*)(a + i), vb);
+			_mm_storeu_si128((__m128i*)(b + i), va);
+		}
+#endif
+
+		SwapBytesScalar(a, b, i, rowSize);
+	}
+}
+
+void ImageKernels::PremultiplyAlpha(unsigned char* rgba, size_t count)
+{
+	size_t i = 0;
+
+#if defined(IMAGE_KERNELS_AVX2)
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i pixels = _mm256_loadu_si256((const __m256i*)(rgba + i * 4));
+		__m256i zero = _mm256_setzero_si256();
+
+		__m256i lo = PremultiplyAlpha8(_mm256_unpacklo_epi8(pixels, zero));
+		__m256i hi = PremultiplyAlpha8(_mm256_unpackhi_epi8(pixels, zero));
+
+		_mm256_storeu_si256((__m256i*)(rgba + i * 4), _mm256_packus_epi16(lo, hi));
+	}
+#endif
+
+#if defined(IMAGE_KERNELS_SSE)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(rgba + i * 4));
+		__m128i zero = _mm_setzero_si128();
+
+		__m128i lo = PremultiplyAlpha4(_mm_unpacklo_epi8(pixels, zero));
+		__m128i hi = PremultiplyAlpha4(_mm_unpackhi_epi8(pixels, zero));
+
+		_mm_storeu_si128((__m128i*)(rgba + i * 4), _mm_packus_epi16(lo, hi));
+	}
+#endif
+
+	PremultiplyAlphaScalar(rgba, i, count);
+}
+
+void ImageKernels::ExpandRGBToRGBA(const unsigned char* rgb, size_t count, unsigned char* rgba)
+{
+	size_t i = 0;
+
+	// the loads read 16 bytes for 12 used, the loops stop while those 4 extra bytes are still in the source
+
+#if defined(IMAGE_KERNELS_SSSE3)
+	__m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	__m128i alpha = _mm_set1_epi32((int)0xFF000000);
+#endif
+
+#if defined(IMAGE_KERNELS_AVX2)
+	__m256i shuffle8 = _mm256_broadcastsi128_si256(shuffle);
+	__m256i alpha8 = _mm256_set1_epi32((int)0xFF000000);
+
+	for (; i + 10 <= count; i += 8)
+	{
+		__m128i lo = _mm_loadu_si128((const __m128i*)(rgb + i * 3));
+		__m128i hi = _mm_loadu_si128((const __m128i*)(rgb + i * 3 + 12));
+		__m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+		_mm256_storeu_si256((__m256i*)(rgba + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle8), alpha8));
+	}
+#endif
+
+#if defined(IMAGE_KERNELS_SSSE3)
+	for (; i + 6 <= count; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(rgb + i * 3));
+
+		_mm_storeu_si128((__m128i*)(rgba + i * 4), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+	}
+#endif
+
+	ExpandRGBToRGBAScalar(rgb, i, count, rgba);
+}
+
+void ImageKernels::Swizzle(unsigned char* rgba, size_t count, const int order[4])
+{
+	size_t i = 0;
+
+#if defined(IMAGE_KERNELS_SSSE3)
+	alignas(16) char mask[16];
+
+	for (int p = 0; p < 4; p++)
+	{
+		for (int c = 0; c < 4; c++)
+			mask[p * 4 + c] = (char)(p * 4 + order[c]);
+	}
+
+	__m128i shuffle = _mm_load_si128((const __m128i*)mask);
+#endif
+
+#if defined(IMAGE_KERNELS_AVX2)
+	__m256i shuffle8 = _mm256_broadcastsi128_si256(shuffle);
+
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i pixels = _mm256_loadu_si256((const __m256i*)(rgba + i * 4));
+		_mm256_storeu_si256((__m256i*)(rgba + i * 4), _mm256_shuffle_epi8(pixels, shuffle8));
+	}
+#endif
+
+#if defined(IMAGE_KERNELS_SSSE3)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i*)(rgba + i * 4));
+		_mm_storeu_si128((__m128i*)(rgba + i * 4), _mm_shuffle_epi8(pixels, shuffle));
+	}
+#endif
+
+	SwizzleScalar(rgba, i, count, order);
+}
+
+void ImageKernels::Downsample2x2(const unsigned char* src, int width, int height, unsigned char* dst, bool srgb)
+{
+	int dstWidth = std::max(width / 2, 1);
+	int dstHeight = std::max(height / 2, 1);
+
+	for (int y = 0; y < dstHeight; y++)
+	{
+		const unsigned char* row0 = src + (size_t)std::min(2 * y, height - 1) * width * 4;
+		const unsigned char* row1 = src + (size_t)std::min(2 * y + 1, height - 1) * width * 4;
+
+		DownsampleRow(row0, row1, width, dst + (size_t)y * dstWidth * 4, dstWidth, srgb);
+	}
+}
+
+unsigned char* ImageKernels::LoadRGBA(const std::string& path, int* width, int* height, int* channels)
+{
+	// decoded with the channels of the file in a single pass, the flag of stb is left as it is (off by default)
+	// and the rows are flipped here
+
+	unsigned char* pixels = stbi_load(path.c_str(), width, height, channels, 0);
+
+	if (pixels == nullptr)
+		return nullptr;
+
+	if (*channels != 4)
+	{
+		// allocated like the stb_image pixels so they are freed the same way
+
+		size_t count = (size_t)*width * *height;
+		unsigned char* rgba = (unsigned char*)malloc(count * 4);
+
+		if (rgba != nullptr)
+		{
+			if (*channels == 3)
+				ExpandRGBToRGBA(pixels, count, rgba);
+			else
+				ExpandGrayToRGBAScalar(pixels, count, *channels == 2, rgba);
+		}
+
+		stbi_image_free(pixels);
+		pixels = rgba;
+
+		if (pixels == nullptr)
+			return nullptr;
+	}
+
+	FlipVertical(pixels, (size_t)*width * 4, *height);
+
+	return pixels;
+}
+
+const char* ImageKernels::GetInstructionSet()
+{
+#if defined(IMAGE_KERNELS_AVX2)
+	return "AVX2";
+#elif defined(IMAGE_KERNELS_SSSE3)
+	return "SSSE3";
+#elif defined(IMAGE_KERNELS_SSE)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
+
+/* SCALAR */
+
+void ImageKernels::Scalar::FlipVertical(unsigned char* pixels, size_t rowSize, int height)
+{
+	for (int y = 0; y < height / 2; y++)
+		SwapBytesScalar(pixels + (size_t)y * rowSize, pixels + (size_t)(height - 1 - y) * rowSize, 0, rowSize);
+}
+
+void ImageKernels::Scalar::PremultiplyAlpha(unsigned char* rgba, size_t count)
+{
+	PremultiplyAlphaScalar(rgba, 0, count);
+}
+
+void ImageKernels::Scalar::ExpandRGBToRGBA(const unsigned char* rgb, size_t count, unsigned char* rgba)
+{
+	ExpandRGBToRGBAScalar(rgb, 0, count, rgba);
+}
+
+void ImageKernels::Scalar::Swizzle(unsigned char* rgba, size_t count, const int order[4])
+{
+	SwizzleScalar(rgba, 0, count, order);
+}
+
+void ImageKernels::Scalar::Downsample2x2(const unsigned char* src, int width, int height, unsigned char* dst, bool srgb)
+{
+	int dstWidth = std::max(width / 2, 1);
+	int dstHeight = std::max(height / 2, 1);
+
+	for (int y = 0; y < dstHeight; y++)
+	{
+		const unsigned char* row0 = src + (size_t)std::min(2 * y, height - 1) * width * 4;
+		const unsigned char* row1 = src + (size_t)std::min(2 * y + 1, height - 1) * width * 4;
+
+		DownsampleRowScalar(row0, row1, width, dst + (size_t)y * dstWidth * 4, 0, dstWidth, srgb);
+	}
+}
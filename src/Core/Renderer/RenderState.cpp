@@ -0,0 +1,355 @@
+#include "Core/Renderer/RenderState.h"
+#include <GL/glew.h>
+#include <unordered_map>
+
+static const unsigned int UNKNOWN = 0xFFFFFFFF; // the cache does not know the binding
+
+static const int MAX_TEXTURE_UNITS = 32;
+static const int MAX_BUFFER_BINDINGS = 16;
+
+enum BufferTarget
+{
+	ARRAY_BUFFER,
+	DRAW_INDIRECT_BUFFER,
+	SHADER_STORAGE_BUFFER,
+	UNIFORM_BUFFER,
+	PIXEL_UNPACK_BUFFER,
+	BUFFER_TARGETS_COUNT
+};
+
+enum TextureTarget
+{
+	TEXTURE_2D,
+	TEXTURE_2D_ARRAY,
+	TEXTURE_TARGETS_COUNT
+};
+
+struct RenderStateData
+{
+	unsigned int program;
+	unsigned int vertexArray;
+	unsigned int buffers[BUFFER_TARGETS_COUNT];
+	unsigned int storageBindings[MAX_BUFFER_BINDINGS];
+	unsigned int uniformBindings[MAX_BUFFER_BINDINGS];
+	std::unordered_map<unsigned int, unsigned int> elementBuffers; // per vertex array
+
+	unsigned int activeUnit;
+	unsigned int textures[MAX_TEXTURE_UNITS][TEXTURE_TARGETS_COUNT];
+
+	unsigned int framebuffer;
+
+	int blendEnabled; // -1 unknown
+	unsigned int blendSrc, blendDst;
+
+	int viewport[4];
+	bool viewportKnown;
+
+	RenderStateStats stats;
+
+	RenderStateData() { Reset(); }
+
+	void Reset()
+	{
+		program = UNKNOWN;
+		vertexArray = UNKNOWN;
+
+		for (auto& buffer : buffers)
+			buffer = UNKNOWN;
+
+		for (int i = 0; i < MAX_BUFFER_BINDINGS; i++)
+		{
+			storageBindings[i] = UNKNOWN;
+			uniformBindings[i] = UNKNOWN;
+		}
+
+		elementBuffers.clear();
+
+		activeUnit = UNKNOWN;
+
+		for (auto& unit : textures)
+		{
+			for (auto& texture : unit)
+				texture = UNKNOWN;
+		}
+
+		framebuffer = UNKNOWN;
+		blendEnabled = -1;
+		blendSrc = UNKNOWN;
+		blendDst = UNKNOWN;
+		viewportKnown = false;
+	}
+};
+
+static RenderStateData rs;
+
+static int GetBufferTarget(unsigned int target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER: return ARRAY_BUFFER;
+	case GL_DRAW_INDIRECT_BUFFER: return DRAW_INDIRECT_BUFFER;
+	case GL_SHADER_STORAGE_BUFFER: return SHADER_STORAGE_BUFFER;
+	case GL_UNIFORM_BUFFER: return UNIFORM_BUFFER;
+	case GL_PIXEL_UNPACK_BUFFER: return PIXEL_UNPACK_BUFFER;
+	default: return -1;
+	}
+}
+
+static int GetTextureTarget(unsigned int target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_2D: return TEXTURE_2D;
+	case GL_TEXTURE_2D_ARRAY: return TEXTURE_2D_ARRAY;
+	default: return -1;
+	}
+}
+
+// true when the cached value already matches, otherwise stores it
+
+static bool Cached(unsigned int& cached, unsigned int value)
+{
+	if (cached == value)
+	{
+		rs.stats.elided++;
+		return true;
+	}
+
+	cached = value;
+	rs.stats.calls++;
+
+	return false;
+}
+
+void RenderState::UseProgram(unsigned int program)
+{
+	if (!Cached(rs.program, program))
+		glUseProgram(program);
+}
+
+void RenderState::BindVertexArray(unsigned int vertexArray)
+{
+	if (!Cached(rs.vertexArray, vertexArray))
+		glBindVertexArray(vertexArray);
+}
+
+void RenderState::BindBuffer(unsigned int target, unsigned int buffer)
+{
+	// the element array binding is part of the vertex array state
+
+	if (target == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		if (rs.vertexArray == UNKNOWN)
+		{
+			rs.stats.calls++;
+			glBindBuffer(target, buffer);
+			return;
+		}
+
+		auto it = rs.elementBuffers.try_emplace(rs.vertexArray, UNKNOWN).first;
+
+		if (!Cached(it->second, buffer))
+			glBindBuffer(target, buffer);
+
+		return;
+	}
+
+	int index = GetBufferTarget(target);
+
+	if (index == -1)
+	{
+		rs.stats.calls++;
+		glBindBuffer(target, buffer);
+	}
+	else if (!Cached(rs.buffers[index], buffer))
+		glBindBuffer(target, buffer);
+}
+
+void RenderState::BindBufferBase(unsigned int target, unsigned int binding, unsigned int buffer)
+{
+	unsigned int* bindings = nullptr;
+
+	if (target == GL_SHADER_STORAGE_BUFFER)
+		bindings = rs.storageBindings;
+	else if (target == GL_UNIFORM_BUFFER)
+		bindings = rs.uniformBindings;
+
+	if (bindings == nullptr || binding >= MAX_BUFFER_BINDINGS)
+	{
+		rs.stats.calls++;
+		glBindBufferBase(target, binding, buffer);
+		return;
+	}
+
+	if (!Cached(bindings[binding], buffer))
+	{
+		glBindBufferBase(target, binding, buffer);
+
+		// glBindBufferBase also binds the generic target
+
+		rs.buffers[GetBufferTarget(target)] = buffer;
+	}
+}
+
+void RenderState::BindTexture(unsigned int target, unsigned int texture)
+{
+	int index = GetTextureTarget(target);
+
+	if (index == -1 || rs.activeUnit >= MAX_TEXTURE_UNITS)
+	{
+		rs.stats.calls++;
+		glBindTexture(target, texture);
+	}
+	else if (!Cached(rs.textures[rs.activeUnit][index], texture))
+		glBindTexture(target, texture);
+}
+
+void RenderState::BindTextureUnit(unsigned int unit, unsigned int target, unsigned int texture)
+{
+	int index = GetTextureTarget(target);
+
+	if (index != -1 && unit < MAX_TEXTURE_UNITS && rs.textures[unit][index] == texture)
+	{
+		rs.stats.elided++;
+		return;
+	}
+
+	if (!Cached(rs.activeUnit, unit))
+		glActiveTexture(GL_TEXTURE0 + unit);
+
+	BindTexture(target, texture);
+}
+
+void RenderState::BindFramebuffer(unsigned int framebuffer)
+{
+	if (!Cached(rs.framebuffer, framebuffer))
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void RenderState::SetBlend(bool enabled, unsigned int srcFactor, unsigned int dstFactor)
+{
+	if (rs.blendEnabled != (int)enabled)
+	{
+		if (enabled)
+			glEnable(GL_BLEND);
+		else
+			glDisable(GL_BLEND);
+
+		rs.blendEnabled = (int)enabled;
+		rs.stats.calls++;
+	}
+	else
+		rs.stats.elided++;
+
+	// the factors are kept while the blending is disabled
+
+	if (!enabled)
+		return;
+
+	if (rs.blendSrc != srcFactor || rs.blendDst != dstFactor)
+	{
+		glBlendFunc(srcFactor, dstFactor);
+
+		rs.blendSrc = srcFactor;
+		rs.blendDst = dstFactor;
+		rs.stats.calls++;
+	}
+	else
+		rs.stats.elided++;
+}
+
+void RenderState::SetViewport(int x, int y, int width, int height)
+{
+	if (rs.viewportKnown && rs.viewport[0] == x && rs.viewport[1] == y && rs.viewport[2] == width && rs.viewport[3] == height)
+	{
+		rs.stats.elided++;
+		return;
+	}
+
+	glViewport(x, y, width, height);
+
+	rs.viewport[0] = x;
+	rs.viewport[1] = y;
+	rs.viewport[2] = width;
+	rs.viewport[3] = height;
+	rs.viewportKnown = true;
+	rs.stats.calls++;
+}
+
+void RenderState::ForgetProgram(unsigned int program)
+{
+	if (rs.program == program)
+		rs.program = 0;
+}
+
+void RenderState::ForgetVertexArray(unsigned int vertexArray)
+{
+	if (rs.vertexArray == vertexArray)
+		rs.vertexArray = 0;
+
+	rs.elementBuffers.erase(vertexArray);
+}
+
+void RenderState::ForgetBuffer(unsigned int buffer)
+{
+	for (auto& cached : rs.buffers)
+	{
+		if (cached == buffer)
+			cached = 0;
+	}
+
+	for (int i = 0; i < MAX_BUFFER_BINDINGS; i++)
+	{
+		if (rs.storageBindings[i] == buffer)
+			rs.storageBindings[i] = 0;
+
+		if (rs.uniformBindings[i] == buffer)
+			rs.uniformBindings[i] = 0;
+	}
+
+	// only the element binding of the bound vertex array is reset by gl, the others just keep a dead name
+
+	for (auto& [vertexArray, cached] : rs.elementBuffers)
+	{
+		if (cached == buffer)
+			cached = vertexArray == rs.vertexArray ? 0 : UNKNOWN;
+	}
+}
+
+void RenderState::ForgetTexture(unsigned int texture)
+{
+	for (auto& unit : rs.textures)
+	{
+		for (auto& cached : unit)
+		{
+			if (cached == texture)
+				cached = 0;
+		}
+	}
+}
+
+void RenderState::ForgetFramebuffer(unsigned int framebuffer)
+{
+	if (rs.framebuffer == framebuffer)
+		rs.framebuffer = 0;
+}
+
+void RenderState::Invalidate()
+{
+	rs.Reset();
+}
+
+void RenderState::CountElidedUniform()
+{
+	rs.stats.uniformsElided++;
+}
+
+const RenderStateStats& RenderState::GetStats()
+{
+	return rs.stats;
+}
+
+void RenderState::ResetStats()
+{
+	rs.stats = RenderStateStats();
+}
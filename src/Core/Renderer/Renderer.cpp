@@ -1,37 +1,181 @@
 #include "Core/Renderer/Renderer.h"
 #include <GL/glew.h>
 #include <memory>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <chrono>
 #include <glm/gtc/matrix_transform.hpp>
 #include "Core/Renderer/Buffer.h"
 #include "Core/Renderer/VertexArray.h"
+#include "Core/Renderer/SpriteKernels.h"
+#include "Core/Renderer/CommandList.h"
+#include "Core/Renderer/SpatialGrid.h"
+#include "Core/Renderer/StaticBatch.h"
+#include "Core/Renderer/GpuProfiler.h"
+#include "Core/Renderer/RenderState.h"
+#include "Core/Renderer/ShaderLibrary.h"
 #include "Core/OrthoCamera.h"
 
+// 24 bytes, the texture id is an integer attribute and the color is normalized (clamped to [0, 1]), the
+// uv stays a float so the rects bigger than the texture repeat it
+
 struct QuadVertex
 {
 	glm::vec2 position;
-	float textureId;
+	uint32_t textureId;
 	glm::vec2 textureUv;
+	Unorm8x4 color;
+};
+
+template<> struct VertexLayout<QuadVertex>
+{
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(QuadVertex, position),
+		VERTEX_ATTRIBUTE(QuadVertex, textureId),
+		VERTEX_ATTRIBUTE(QuadVertex, textureUv),
+		VERTEX_ATTRIBUTE(QuadVertex, color)
+	};
+};
+
+static_assert(sizeof(QuadVertex) == 24, "unexpected padding in the packed quad vertex");
+static_assert(offsetof(QuadVertex, position) == 0 && sizeof(QuadVertex) % sizeof(float) == 0, "the sprite kernels write the positions as floats");
+
+struct QuadInstance
+{
+	glm::vec2 position; // center of the quad
+	glm::vec2 size;
+	float rotation;
+	float textureId;
+	glm::vec4 textureRect; // uv of the top left corner and uv size
 	glm::vec4 color;
 };
 
+template<> struct VertexLayout<QuadInstance>
+{
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(QuadInstance, position),
+		VERTEX_ATTRIBUTE(QuadInstance, size),
+		VERTEX_ATTRIBUTE(QuadInstance, rotation),
+		VERTEX_ATTRIBUTE(QuadInstance, textureId),
+		VERTEX_ATTRIBUTE(QuadInstance, textureRect),
+		VERTEX_ATTRIBUTE(QuadInstance, color)
+	};
+};
+
+static_assert(sizeof(QuadInstance) == 14 * sizeof(float), "quads_pulling.glsl reads 14 floats per quad");
+
 struct LineVertex
 {
 	glm::vec2 position;
-	glm::vec4 color;
+	Unorm8x4 color;
+};
+
+template<> struct VertexLayout<LineVertex>
+{
+	static constexpr VertexAttribute attributes[] = {
+		VERTEX_ATTRIBUTE(LineVertex, position),
+		VERTEX_ATTRIBUTE(LineVertex, color)
+	};
+};
+
+struct DrawCommand
+{
+	uint64_t key;
+	uint32_t index; // into the quad or line commands
+};
+
+// std140 layout of the Camera uniform block
+
+struct CameraUniforms
+{
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::mat4 viewProjection;
+	glm::vec2 viewportSize;
+	float time;
+	float deltaTime;
+};
+
+static_assert(sizeof(CameraUniforms) == 208, "CameraUniforms must match the std140 layout of the Camera block");
+
+struct DrawElementsIndirectCommand
+{
+	unsigned int count;
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance;
+};
+
+struct TextureArray
+{
+	unsigned int id;
+	int width, height;
+	unsigned int format;
+	int levels; // the ones of its textures, every level is copied
+	int layersCount;
+	int capacity;
+	std::vector<unsigned int> layerTextures; // texture copied into each layer
+	std::vector<unsigned int> layerRevisions; // and the revision of its pixels
+};
+
+// structure of arrays for the sprite kernels
+
+struct SpriteChunk
+{
+	static const int SIZE = 256;
+
+	alignas(32) float centerX[SIZE];
+	alignas(32) float centerY[SIZE];
+	alignas(32) float halfWidth[SIZE];
+	alignas(32) float halfHeight[SIZE];
+	alignas(32) float radians[SIZE];
+	alignas(32) float sin[SIZE];
+	alignas(32) float cos[SIZE];
+	int slots[SIZE];
+	const glm::vec4* textureRects[SIZE];
+	const glm::vec4* colors[SIZE];
 };
 
 struct RendererData
 {
+	RendererSpecification specification;
+
 	OrthoCamera camera;
 
+	// camera uniform block, uploaded before the first draw after a change
+
+	UniformBuffer cameraUB;
+	CameraUniforms cameraUniforms;
+	bool cameraUniformsDirty;
+	std::chrono::steady_clock::time_point startTime;
+	std::chrono::steady_clock::time_point frameTime;
+
 	/* QUADS */
 
-	const int MAX_QUADS = 10000;
+	int maxQuads; // quads per batch, the initial capacity in vertex pulling mode
 
 	VertexArray quadsVA;
-	VertexBuffer quadsVB;
+	VertexBuffer quadsVB; // quad vertices or quad instances depending on the mode
+	VertexBuffer unitQuadVB; // instanced mode
 	IndexBuffer quadsIB;
-	QuadVertex* quadsVD;
+	QuadVertex* quadsVD; // where the current batch is written (staging array or mapped region)
+	QuadInstance* quadsID; // same for the instanced and vertex pulling modes
+	void* quadsRegion; // start of the locked region when streaming
+	int quadsRegionUsed; // quads already flushed from the locked region
+	int quadsCapacity; // quads that still fit in the current batch
+
+	// vertex pulling, the records are appended to a storage buffer that is orphaned when it is full and
+	// grows with the batches
+
+	std::vector<QuadInstance> pulledQuads;
+	StorageBuffer pulledQuadsSB;
+	int pulledQuadsUsed; // quads already written to the storage buffer
+	int maxPulledQuads;
 
 	int textureSlots;
 	int texturesCount;
@@ -39,7 +183,33 @@ struct RendererData
 	unsigned int texturesId[32];
 	int quadsCount;
 
-	std::unique_ptr<Shader> quadsShader;
+	TextureBindingMode textureBinding;
+	unsigned int texturesGeneration; // the index stored on a texture is valid while it matches
+
+	// bindless
+
+	std::vector<uint64_t> textureHandles;
+	StorageBuffer textureHandlesSB;
+
+	// texture arrays
+
+	std::vector<TextureArray> textureArrays;
+	int maxArrayLayers;
+
+	Shader* quadsShader; // owned by the shader library
+	UniformHandle quadsSamplers;
+
+	Shader* staticBatchShader; // quads.glsl without defines, the vertex format of the static batches
+	UniformHandle staticBatchSamplers;
+
+	// multi draw indirect, the batches of a region are drawn with one call
+
+	bool multiDrawIndirect;
+	std::vector<DrawElementsIndirectCommand> indirectCommands;
+	IndirectBuffer indirectBuffer;
+	uint64_t slotHandles[32]; // bindless handles of the slots of the current batch
+	std::vector<uint64_t> drawTextureHandles; // 32 per draw, the texture table of each batch in slots mode
+	StorageBuffer drawTexturesSB;
 
 	/* LINES */
 
@@ -48,398 +218,2259 @@ struct RendererData
 	VertexArray linesVA;
 	VertexBuffer linesVB;
 	LineVertex* linesVD;
+	LineVertex* linesRegion;
+	int linesRegionUsed;
+	int linesCapacity;
 
 	int linesCount;
 
-	std::unique_ptr<Shader> linesShader;
-};
+	Shader* linesShader;
 
-static RendererData rd;
+	// triangle lines, drawn with a white texture in the quad batch
 
-void Renderer::Init()
-{
-	/* INIT */
+	float lineWidth;
+	std::unique_ptr<Texture> whiteTexture;
+	std::vector<glm::vec2> polylinePoints;
+	std::vector<glm::vec2> polylineOffsets; // offset at the end of the segment arriving to a point and at the start of the one leaving it
 
-	// camera
+	/* STATE */
 
-	rd.camera.SetSize(1280, 720);
+	int layer;
+	BlendMode blendMode;
+	BlendMode appliedBlendMode;
 
-	// get texture slots
+	/* DEFERRED COMMANDS */
 
-	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &rd.textureSlots);
+	std::vector<DrawCommand> commands;
+	std::vector<DrawCommand> commandsTemp;
+	std::vector<QuadCommand> quadCommands;
+	std::vector<LineCommand> lineCommands;
+	uint32_t commandsSequence;
 
-	for (int i = 0; i < rd.textureSlots; i++)
-		rd.samplers[i] = i;
+	CommandQueueStats commandQueueStats;
 
-	// texture ids
+	/* BULK SPRITES */
 
-	memset(rd.texturesId, 0, rd.textureSlots * sizeof(unsigned int));
+	SpriteChunk spriteChunk;
 
-	rd.quadsCount = 0;
-	rd.linesCount = 0;
+	// sprites returned by the spatial grids
 
-	/* QUADS */
+	std::vector<SpriteInstance> visibleSprites;
 
-	// vertex buffer
+	/* STATIC BATCHES */
 
-	rd.quadsVB.Create(4 * rd.MAX_QUADS * sizeof(QuadVertex));
+	std::vector<QuadVertex> staticVertices;
 
-	// vertex data
+	/* PROFILING */
 
-	rd.quadsVD = new QuadVertex[4 * rd.MAX_QUADS];
+	GpuProfiler gpuProfiler;
 
-	// vertex buffer layout
+	RendererStats stats; // current frame
+	RendererStats lastFrameStats;
 
-	VertexBufferLayout quadsVBL;
+	// stats export
 
-	quadsVBL.AddElement<float>(2); // position
-	quadsVBL.AddElement<float>(1); // texture id
-	quadsVBL.AddElement<float>(2); // texture uv
-	quadsVBL.AddElement<float>(4); // color
+	std::ofstream statsFile;
+	StatsExportFormat statsFormat;
+	float statsInterval;
+	std::chrono::steady_clock::time_point statsStart;
+	std::chrono::steady_clock::time_point statsLastWrite;
+	RendererStats statsSum; // frames since the last write
+	int statsFrames;
+};
 
-	// index buffer
+static RendererData rd;
 
-	// generate and set index buffer data
+enum class FlushReason
+{
+	CAPACITY,
+	TEXTURE_SLOTS,
+	STATE_CHANGE,
+	EXPLICIT
+};
 
-	unsigned int* quadsIBD = new unsigned int[6 * rd.MAX_QUADS];
+static void CountFlush(FlushReason reason)
+{
+	switch (reason)
+	{
+	case FlushReason::CAPACITY: rd.stats.flushesCapacity++; break;
+	case FlushReason::TEXTURE_SLOTS: rd.stats.flushesTextureSlots++; break;
+	case FlushReason::STATE_CHANGE: rd.stats.flushesStateChange++; break;
+	default: rd.stats.flushesExplicit++; break;
+	}
+}
 
-	int n = 0;
+static void UpdateCameraUniforms()
+{
+	// bound every time (the cache elides it) in case another buffer took the binding
 
-	for (int i = 0; i < 6 * rd.MAX_QUADS; i += 6) {
-		quadsIBD[i] = n;
-		quadsIBD[i + 1] = n + 1;
-		quadsIBD[i + 2] = n + 2;
-		quadsIBD[i + 3] = n + 2;
-		quadsIBD[i + 4] = n + 3;
-		quadsIBD[i + 5] = n;
+	rd.cameraUB.Bind(CAMERA_UNIFORM_BINDING);
 
-		n += 4;
-	}
+	if (!rd.cameraUniformsDirty)
+		return;
 
-	rd.quadsIB.Create(6 * rd.MAX_QUADS, quadsIBD);
+	rd.cameraUniforms.projection = rd.camera.GetProjection();
+	rd.cameraUniforms.view = rd.camera.GetView();
+	rd.cameraUniforms.viewProjection = rd.camera.GetViewProjection();
 
-	delete[] quadsIBD;
+	rd.cameraUB.SetData(0, sizeof(CameraUniforms), &rd.cameraUniforms);
+	rd.cameraUniformsDirty = false;
 
-	// vertex array
+	rd.stats.bytesUploaded += sizeof(CameraUniforms);
+}
 
-	rd.quadsVA.Create(rd.quadsVB, quadsVBL);
+static bool IsInstanced()
+{
+	return rd.specification.quadMode == QuadRenderMode::INSTANCED;
+}
 
-	// shader
+static bool IsVertexPulling()
+{
+	return rd.specification.quadMode == QuadRenderMode::VERTEX_PULLING;
+}
 
-	rd.quadsShader = std::make_unique<Shader>("Assets/Shaders/quads.glsl");
+static bool UsesQuadRecords()
+{
+	// one QuadInstance per quad instead of four vertices
 
-	/* LINES */
+	return rd.specification.quadMode != QuadRenderMode::BATCHED;
+}
 
-	// vertex buffer and data
+/* streaming regions */
 
-	rd.linesVB.Create(2 * rd.MAX_LINES * sizeof(LineVertex));
+static void SetQuadsWritePointer()
+{
+	// the next batch is written right after the quads already flushed from the region
 
-	rd.linesVD = new LineVertex[2 * rd.MAX_LINES];
+	if (IsInstanced())
+		rd.quadsID = (QuadInstance*)rd.quadsRegion + rd.quadsRegionUsed;
+	else
+		rd.quadsVD = (QuadVertex*)rd.quadsRegion + 4 * rd.quadsRegionUsed;
 
-	// vertex buffer layout
+	rd.quadsCapacity = rd.maxQuads - rd.quadsRegionUsed;
+}
 
-	VertexBufferLayout linesVBL;
+static void SubmitIndirectQuads();
 
-	linesVBL.AddElement<float>(2); // position
-	linesVBL.AddElement<float>(4); // color
+static void NextQuadsRegion()
+{
+	// the fence of the region has to come after the draws that read it
 
-	// vertex array
+	SubmitIndirectQuads();
 
-	rd.linesVA.Create(rd.linesVB, linesVBL);
+	if (rd.quadsRegion != nullptr)
+		rd.quadsVB.UnlockRegion();
 
-	// shader
+	rd.quadsRegion = rd.quadsVB.LockRegion();
+	rd.quadsRegionUsed = 0;
 
-	rd.linesShader = std::make_unique<Shader>("Assets/Shaders/lines.glsl");
+	SetQuadsWritePointer();
 }
 
-void Renderer::Destroy()
+static void NextLinesRegion()
 {
-	delete[] rd.quadsVD;
-	delete[] rd.linesVD;
-}
+	if (rd.linesRegion != nullptr)
+		rd.linesVB.UnlockRegion();
 
-void Renderer::SetClearColor(const glm::vec4& color)
-{
-	glClearColor(color.r, color.g, color.b, color.a);
+	rd.linesRegion = (LineVertex*)rd.linesVB.LockRegion();
+	rd.linesRegionUsed = 0;
+	rd.linesVD = rd.linesRegion;
+	rd.linesCapacity = rd.MAX_LINES;
 }
 
-void Renderer::Clear()
+static ShaderDefines GetQuadsShaderDefines()
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-}
+	// slots with multi draw indirect read the per draw texture tables
 
-void Renderer::SetViewport(int x, int y, int width, int height)
-{
-	glViewport(x, y, width, height);
+	if (rd.multiDrawIndirect && rd.textureBinding == TextureBindingMode::SLOTS)
+		return { "DRAW_TEXTURES" };
+
+	switch (rd.textureBinding)
+	{
+	case TextureBindingMode::BINDLESS:
+		return { "BINDLESS_TEXTURES" };
+	case TextureBindingMode::ARRAY:
+		return { "TEXTURE_ARRAYS" };
+	default:
+		return {};
+	}
 }
 
-void Renderer::SetViewportAspectRatio(int windowWidth, int windowHeight, float targetAspectRatio)
+static void CreateQuadsIndexBuffer(IndexBuffer& ib, int quadsCount)
 {
-	// calculate target viewport size
+	// generate and set index buffer data
 
-    float window_aspect_ratio = windowWidth / (float)windowHeight;
+	unsigned int* quadsIBD = new unsigned int[6 * quadsCount];
 
-    int targetX = 0;
-    int targetY = 0;
-    int targetWidth = windowWidth;
-    int targetHeight = windowHeight;
+	int n = 0;
 
-    if (window_aspect_ratio > targetAspectRatio)
-    {
-        targetWidth = targetHeight * targetAspectRatio;
-        targetX = (windowWidth - targetWidth) / 2;
-    }
-    else
-    {
-        targetHeight = targetWidth * (1 / targetAspectRatio);
-        targetY = (windowHeight - targetHeight) / 2;
-    }
+	for (int i = 0; i < 6 * quadsCount; i += 6) {
+		quadsIBD[i] = n;
+		quadsIBD[i + 1] = n + 1;
+		quadsIBD[i + 2] = n + 2;
+		quadsIBD[i + 3] = n + 2;
+		quadsIBD[i + 4] = n + 3;
+		quadsIBD[i + 5] = n;
 
-    glViewport(targetX, targetY, targetWidth, targetHeight);
-}
+		n += 4;
+	}
 
-void Renderer::SetLineWidth(float width)
-{
-	glLineWidth(width);
+	ib.Create(6 * quadsCount, quadsIBD);
+
+	delete[] quadsIBD;
 }
 
-void Renderer::StartBatch()
+static void InitBatchedQuads()
 {
-	// reset for quads
+	// index buffer
 
-	rd.quadsCount = 0;
-	rd.texturesCount = 0;
-	
-	// reset for lines
+	CreateQuadsIndexBuffer(rd.quadsIB, rd.maxQuads);
 
-	rd.linesCount = 0;
+	// vertex array
+
+	rd.quadsVA.Create(rd.quadsVB, VertexBufferLayout::Create<QuadVertex>());
+
+	// shader
+
+	rd.quadsShader = ShaderLibrary::Get("Assets/Shaders/quads.glsl", GetQuadsShaderDefines());
 }
 
-static void FlushQuads()
+static void InitInstancedQuads()
 {
-	if (rd.quadsCount > 0)
-	{
-		// bind shader
-		
-		rd.quadsShader->Bind();
-		rd.quadsShader->SetUniformMat4("u_projection", rd.camera.GetProjection());
-		rd.quadsShader->SetUniformMat4("u_view", rd.camera.GetView());
-		rd.quadsShader->SetUniform1iv("u_textures", rd.textureSlots, rd.samplers);
+	// unit quad expanded by the vertex shader for every instance
 
-		// bind textures
-
-		for (int i = 0; i < rd.texturesCount; i++)
-		{
-			glActiveTexture(GL_TEXTURE0 + i);
-			glBindTexture(GL_TEXTURE_2D, rd.texturesId[i]);
-		}
+	glm::vec2 unitQuad[4] = {
+		{-0.5f, -0.5f},
+		{ 0.5f, -0.5f},
+		{ 0.5f,  0.5f},
+		{-0.5f,  0.5f}
+	};
 
-		// bind quads_vbo and set data
+	rd.unitQuadVB.Create(sizeof(unitQuad), unitQuad);
 
-		rd.quadsVB.Bind();
-		rd.quadsVB.SetData(4 * rd.quadsCount * sizeof(QuadVertex), rd.quadsVD);
+	VertexBufferLayout unitQuadVBL;
 
-		// bind vertex array
+	unitQuadVBL.AddElement<float>(2); // corner
 
-		rd.quadsVA.Bind();
+	// index buffer
 
-		// bind index buffer
+	unsigned int unitQuadIBD[6] = { 0, 1, 2, 2, 3, 0 };
 
-		rd.quadsIB.Bind();
+	rd.quadsIB.Create(6, unitQuadIBD);
 
-		// draw call
+	// vertex array, the instance records advance once per instance
 
-		glDrawElements(GL_TRIANGLES, 6 * rd.quadsCount, GL_UNSIGNED_INT, nullptr);
-	}
+	rd.quadsVA.Create(rd.unitQuadVB, unitQuadVBL);
+	rd.quadsVA.AddVertexBuffer(rd.quadsVB, VertexBufferLayout::Create<QuadInstance>(1));
 
-	// reset
+	// shader
 
-	rd.quadsCount = 0;
-	rd.texturesCount = 0;
-	// memset(rd.texturesId, 0, rd.textureSlots * sizeof(unsigned int));
+	rd.quadsShader = ShaderLibrary::Get("Assets/Shaders/quads_instanced.glsl", GetQuadsShaderDefines());
 }
 
-static void FlushLines()
+static void InitPulledQuads()
 {
-	if (rd.linesCount > 0)
-	{
-		// bind shader and set uniforms
-
-		rd.linesShader->Bind();
-		rd.linesShader->SetUniformMat4("u_projection", rd.camera.GetProjection());
+	// no vertex attributes, the vertex shader reads the quad of gl_VertexID / 6 from the storage buffer
 
-		// set vertex buffer data
+	GLint maxBlockSize;
+	glGetIntegerv(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &maxBlockSize);
 
-		rd.linesVB.Bind();
-		rd.linesVB.SetData(2 * rd.linesCount * sizeof(LineVertex), rd.linesVD);
+	rd.maxPulledQuads = std::max((int)((unsigned int)maxBlockSize / sizeof(QuadInstance)), rd.maxQuads);
 
-		// bind vertex array
+	rd.pulledQuads.resize(rd.maxQuads);
+	rd.quadsID = rd.pulledQuads.data();
+	rd.quadsCapacity = rd.maxQuads;
 
-		rd.linesVA.Bind();
+	// room for a few batches before the first orphan
 
-		// draw call
+	rd.pulledQuadsSB.Create(std::min(4 * rd.maxQuads, rd.maxPulledQuads) * sizeof(QuadInstance));
+	rd.pulledQuadsUsed = 0;
 
-		glDrawArrays(GL_LINES, 0, 2 * rd.linesCount);
-	}
+	// core profile draws need a vertex array even without attributes
 
-	rd.linesCount = 0;
-}
+	rd.quadsVA.Create();
 
-void Renderer::Flush()
-{
-	FlushQuads();
+	// shader
 
-	FlushLines();
+	rd.quadsShader = ShaderLibrary::Get("Assets/Shaders/quads_pulling.glsl", GetQuadsShaderDefines());
 }
 
-void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec4& color)
+static bool GrowPulledQuads()
 {
-	if (texture == nullptr)
-		return;
+	// a full batch doubles instead of flushing, up to the size limit of the storage block
 
-	DrawTexture(texture, position, { texture->GetWidth(), texture->GetHeight() }, color);
-}
+	if (!IsVertexPulling() || rd.quadsCapacity >= rd.maxPulledQuads)
+		return false;
 
-void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
-{
-	if (texture == nullptr)
-		return;
+	rd.quadsCapacity = std::min(2 * rd.quadsCapacity, rd.maxPulledQuads);
+	rd.pulledQuads.resize(rd.quadsCapacity);
+	rd.quadsID = rd.pulledQuads.data();
 
-	DrawTexture(texture, position, size, { 0, 0 }, { texture->GetWidth(), texture->GetHeight() }, color);
+	return true;
 }
 
-void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPosition, const glm::vec2& srcSize, const glm::vec4& color)
+void Renderer::Init(const RendererSpecification& specification)
 {
-	if (texture == nullptr)
-		return;
-
-	// check if it needs to make a new batch
+	/* INIT */
 
-	if (rd.quadsCount >= rd.MAX_QUADS || rd.texturesCount >= rd.textureSlots)
-		FlushQuads();
+	rd.specification = specification;
+	rd.maxQuads = std::max(rd.specification.maxQuads, 1);
 
-	// get texture slot
+	// camera
 
-	int slot = -1;
+	rd.camera.SetSize(1280, 720);
 
-	for (int i = 0; i < rd.texturesCount; i++) {
-		if (texture->GetId() == rd.texturesId[i]) {
-			slot = i;
-			break;
-		}
-	}
+	int viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
 
-	if (slot == -1) {
-		rd.texturesId[rd.texturesCount] = texture->GetId();
-		slot = rd.texturesCount;
-		rd.texturesCount++;
-	}
+	rd.cameraUB.Create(sizeof(CameraUniforms));
+	rd.cameraUniforms = {};
+	rd.cameraUniforms.viewportSize = { (float)viewport[2], (float)viewport[3] };
+	rd.cameraUniformsDirty = true;
+	rd.startTime = std::chrono::steady_clock::now();
+	rd.frameTime = rd.startTime;
 
-	// normalize the srcPosition and srcSize
+	// get texture slots
 
-	glm::vec2 srcPositionNormalized = { srcPosition.x / (float)texture->GetWidth(), srcPosition.y / (float)texture->GetHeight() };
-	glm::vec2 srcSizeNormalized = { srcSize.x / (float)texture->GetWidth(), srcSize.y / (float)texture->GetHeight() };
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &rd.textureSlots);
 
-	// set the vertex data (position, texture id, texture uv, color)
+	rd.textureSlots = std::min(rd.textureSlots, 32);
 
-	int index = rd.quadsCount * 4;
+	for (int i = 0; i < rd.textureSlots; i++)
+		rd.samplers[i] = i;
 
-	rd.quadsVD[index]     = { {position.x         , position.y + size.y }, (float)slot, {srcPositionNormalized.x                        , 1 - (srcPositionNormalized.y + srcSizeNormalized.y) }, color };
-	rd.quadsVD[index + 1] = { {position.x + size.x, position.y + size.y }, (float)slot, {srcPositionNormalized.x + srcSizeNormalized.x, 1 - (srcPositionNormalized.y + srcSizeNormalized.y) }, color };
-	rd.quadsVD[index + 2] = { {position.x + size.x, position.y		  	 }, (float)slot, {srcPositionNormalized.x + srcSizeNormalized.x, 1 - srcPositionNormalized.y                           }, color };
-	rd.quadsVD[index + 3] = { {position.x         , position.y		  	 }, (float)slot, {srcPositionNormalized.x                        , 1 - srcPositionNormalized.y                           }, color };
+	// texture ids
 
-	// increment the number of quads
+	memset(rd.texturesId, 0, rd.textureSlots * sizeof(unsigned int));
 
-	rd.quadsCount++;
-}
+	rd.quadsCount = 0;
+	rd.linesCount = 0;
 
-void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, float radians, const glm::vec4& color)
-{
-	if (texture == nullptr)
-		return;
+	// blending is left untouched until a blend mode is set (or a deferred flush applies the one of its commands)
 
-	DrawTexture(texture, position, { texture->GetWidth(), texture->GetHeight() }, radians, color);
-}
+	rd.layer = 0;
+	rd.blendMode = BlendMode::NONE;
+	rd.appliedBlendMode = BlendMode::NONE;
 
-void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color)
-{
-	if (texture == nullptr)
-		return;
+	// texture binding
 
-	DrawTexture(texture, position, size, { 0.0f, 0.0f }, { texture->GetWidth(), texture->GetHeight() }, radians, color);
-}
+	rd.textureBinding = rd.specification.textureBinding;
+	rd.texturesGeneration = 1;
 
-void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPosition, const glm::vec2& srcSize, float radians, const glm::vec4& color)
-{
-	if (texture == nullptr)
-		return;
+	if (rd.textureBinding == TextureBindingMode::BINDLESS && !GLEW_ARB_bindless_texture)
+	{
+		std::cout << "[WARNING] Bindless textures not supported, using texture arrays" << std::endl;
+		rd.textureBinding = TextureBindingMode::ARRAY;
+	}
 
-	// check if it needs to make a new batch
+	if (rd.textureBinding == TextureBindingMode::BINDLESS)
+		rd.textureHandlesSB.Create(1024 * sizeof(uint64_t));
 
-	if (rd.quadsCount >= rd.MAX_QUADS || rd.texturesCount >= rd.textureSlots)
-		FlushQuads();
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &rd.maxArrayLayers);
 
-	// get texture slot
+	// multi draw indirect needs the batches to stay in the streaming region until they are drawn and,
+	// with texture slots, bindless handles for the per draw texture tables
 
-	int slot = -1;
+	rd.multiDrawIndirect = rd.specification.multiDrawIndirect;
 
-	for (int i = 0; i < rd.texturesCount; i++) {
-		if (texture->GetId() == rd.texturesId[i]) {
-			slot = i;
-			break;
-		}
+	if (rd.multiDrawIndirect && (!rd.specification.streamingBuffers || rd.specification.quadMode == QuadRenderMode::VERTEX_PULLING || !GLEW_ARB_multi_draw_indirect))
+	{
+		std::cout << "[WARNING] Multi draw indirect needs streaming buffers and does not apply to vertex pulling, disabled" << std::endl;
+		rd.multiDrawIndirect = false;
 	}
 
-	if (slot == -1) {
-		rd.texturesId[rd.texturesCount] = texture->GetId();
-		slot = rd.texturesCount;
-		rd.texturesCount++;
+	if (rd.multiDrawIndirect && rd.textureBinding == TextureBindingMode::SLOTS && !(GLEW_ARB_bindless_texture && GLEW_ARB_shader_draw_parameters))
+	{
+		std::cout << "[WARNING] Multi draw indirect with texture slots needs bindless textures and shader draw parameters, disabled" << std::endl;
+		rd.multiDrawIndirect = false;
 	}
 
-	// normalize the srcPosition and srcSize
+	if (rd.multiDrawIndirect)
+		rd.indirectBuffer.Create(64 * sizeof(DrawElementsIndirectCommand));
 
-	glm::vec2 srcPositionNormalized = { srcPosition.x / (float)texture->GetWidth(), srcPosition.y / (float)texture->GetHeight() };
+	/* QUADS */
+
+	// vertex buffer and data
+
+	size_t quadSize = IsInstanced() ? sizeof(QuadInstance) : 4 * sizeof(QuadVertex);
+
+	rd.quadsRegion = nullptr;
+
+	if (IsVertexPulling())
+	{
+		// the storage buffer is not streamed, it has to be able to grow
+
+		InitPulledQuads();
+	}
+	else if (rd.specification.streamingBuffers)
+	{
+		rd.quadsVB.CreateStreaming(rd.maxQuads * quadSize, rd.specification.framesInFlight);
+		NextQuadsRegion();
+	}
+	else
+	{
+		rd.quadsVB.Create(rd.maxQuads * quadSize);
+
+		// 32 byte aligned for the sprite kernels
+
+		if (IsInstanced())
+			rd.quadsID = new QuadInstance[rd.maxQuads];
+		else
+			rd.quadsVD = (QuadVertex*)::operator new[](4 * rd.maxQuads * sizeof(QuadVertex), std::align_val_t(32));
+
+		rd.quadsCapacity = rd.maxQuads;
+	}
+
+	if (IsInstanced())
+		InitInstancedQuads();
+	else if (!IsVertexPulling())
+		InitBatchedQuads();
+
+	/* LINES */
+
+	// vertex buffer and data
+
+	rd.linesRegion = nullptr;
+
+	if (rd.specification.streamingBuffers)
+	{
+		rd.linesVB.CreateStreaming(2 * rd.MAX_LINES * sizeof(LineVertex), rd.specification.framesInFlight);
+		NextLinesRegion();
+	}
+	else
+	{
+		rd.linesVB.Create(2 * rd.MAX_LINES * sizeof(LineVertex));
+		rd.linesVD = new LineVertex[2 * rd.MAX_LINES];
+		rd.linesCapacity = rd.MAX_LINES;
+	}
+
+	// vertex array
+
+	rd.linesVA.Create(rd.linesVB, VertexBufferLayout::Create<LineVertex>());
+
+	// shaders, compiled at the same time as the quads shader (the static batch one is the same program in
+	// the default mode)
+
+	rd.linesShader = ShaderLibrary::Get("Assets/Shaders/lines.glsl");
+	rd.staticBatchShader = ShaderLibrary::Get("Assets/Shaders/quads.glsl");
+
+	// sampler array of the quads shader, bindless and the per draw texture tables have none
+
+	if (rd.textureBinding == TextureBindingMode::ARRAY)
+		rd.quadsSamplers = rd.quadsShader->GetUniformHandle("u_textureArrays");
+	else if (rd.textureBinding == TextureBindingMode::SLOTS && !rd.multiDrawIndirect)
+		rd.quadsSamplers = rd.quadsShader->GetUniformHandle("u_textures");
+
+	rd.staticBatchSamplers = rd.staticBatchShader->GetUniformHandle("u_textures");
+
+	// white texture for the triangle lines
+
+	rd.lineWidth = 1.0f;
+
+	uint32_t white = 0xFFFFFFFF;
+
+	rd.whiteTexture = std::make_unique<Texture>(1, 1);
+	rd.whiteTexture->SetPixels(1, 1, &white);
+
+	// gpu timings, read back framesInFlight + 1 frames late so the results are ready
+
+	if (rd.specification.gpuProfiling)
+		rd.gpuProfiler.Init(rd.specification.framesInFlight + 1);
+}
+
+void Renderer::Destroy()
+{
+	for (auto& textureArray : rd.textureArrays)
+	{
+		RenderState::ForgetTexture(textureArray.id);
+		glDeleteTextures(1, &textureArray.id);
+	}
+
+	rd.textureArrays.clear();
+	rd.textureHandles.clear();
+
+	rd.whiteTexture.reset();
+	rd.gpuProfiler.Destroy();
+
+	// the renderer shaders and every permutation the application asked for
+
+	ShaderLibrary::Clear();
+	rd.quadsShader = nullptr;
+	rd.linesShader = nullptr;
+	rd.staticBatchShader = nullptr;
+
+	StopStatsExport();
+
+	// streaming buffers are written in place, there is no staging data to free
+
+	if (!rd.specification.streamingBuffers)
+	{
+		if (!IsVertexPulling())
+		{
+			::operator delete[](rd.quadsVD, std::align_val_t(32));
+			delete[] rd.quadsID;
+		}
+
+		delete[] rd.linesVD;
+	}
+
+	rd.pulledQuads.clear();
+}
+
+void Renderer::SetClearColor(const glm::vec4& color)
+{
+	glClearColor(color.r, color.g, color.b, color.a);
+}
+
+void Renderer::Clear()
+{
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void Renderer::SetViewport(int x, int y, int width, int height)
+{
+	RenderState::SetViewport(x, y, width, height);
+
+	rd.cameraUniforms.viewportSize = { (float)width, (float)height };
+	rd.cameraUniformsDirty = true;
+}
+
+void Renderer::SetViewportAspectRatio(int windowWidth, int windowHeight, float targetAspectRatio)
+{
+	// calculate target viewport size
+
+    float window_aspect_ratio = windowWidth / (float)windowHeight;
+
+    int targetX = 0;
+    int targetY = 0;
+    int targetWidth = windowWidth;
+    int targetHeight = windowHeight;
+
+    if (window_aspect_ratio > targetAspectRatio)
+    {
+        targetWidth = targetHeight * targetAspectRatio;
+        targetX = (windowWidth - targetWidth) / 2;
+    }
+    else
+    {
+        targetHeight = targetWidth * (1 / targetAspectRatio);
+        targetY = (windowHeight - targetHeight) / 2;
+    }
+
+    RenderState::SetViewport(targetX, targetY, targetWidth, targetHeight);
+
+	rd.cameraUniforms.viewportSize = { (float)targetWidth, (float)targetHeight };
+	rd.cameraUniformsDirty = true;
+}
+
+void Renderer::SetLineWidth(float width)
+{
+	rd.lineWidth = width;
+
+	if (rd.specification.lineMode == LineRenderMode::LINES)
+		glLineWidth(width);
+}
+
+void Renderer::StartBatch()
+{
+	// reset for quads
+
+	rd.quadsCount = 0;
+	rd.texturesCount = 0;
+
+	if (rd.textureBinding == TextureBindingMode::SLOTS)
+		rd.texturesGeneration++;
+	
+	// reset for lines
+
+	rd.linesCount = 0;
+
+	// reset the deferred commands
+
+	rd.commands.clear();
+	rd.quadCommands.clear();
+	rd.lineCommands.clear();
+	rd.commandsSequence = 0;
+
+	// start the frame on a fresh region of the streaming buffers
+
+	if (rd.specification.streamingBuffers)
+	{
+		if (rd.quadsRegionUsed > 0)
+			NextQuadsRegion();
+
+		if (rd.linesRegionUsed > 0)
+			NextLinesRegion();
+	}
+}
+
+static void BindQuadsTextures()
+{
+	switch (rd.textureBinding)
+	{
+	case TextureBindingMode::BINDLESS:
+	{
+		// every handle lives in the storage buffer, nothing to bind per texture
+
+		rd.textureHandlesSB.Bind(0);
+		break;
+	}
+	case TextureBindingMode::ARRAY:
+	{
+		rd.quadsShader->SetUniform1iv(rd.quadsSamplers, rd.textureSlots, rd.samplers);
+
+		for (int i = 0; i < (int)rd.textureArrays.size(); i++)
+		{
+			auto& textureArray = rd.textureArrays[i];
+
+			RenderState::BindTextureUnit(i, GL_TEXTURE_2D_ARRAY, textureArray.id);
+			rd.stats.textureBinds++;
+		}
+
+		break;
+	}
+	default:
+	{
+		// per draw texture tables, the shader picks the table with the draw id
+
+		if (rd.multiDrawIndirect)
+		{
+			size_t size = rd.drawTextureHandles.size() * sizeof(uint64_t);
+
+			if (rd.drawTexturesSB.GetSize() < size)
+				rd.drawTexturesSB.Create(2 * size);
+
+			rd.drawTexturesSB.SetData(0, size, rd.drawTextureHandles.data());
+			rd.drawTexturesSB.Bind(2);
+			rd.stats.bytesUploaded += size;
+			break;
+		}
+
+		rd.quadsShader->SetUniform1iv(rd.quadsSamplers, rd.textureSlots, rd.samplers);
+
+		for (int i = 0; i < rd.texturesCount; i++)
+		{
+			RenderState::BindTextureUnit(i, GL_TEXTURE_2D, rd.texturesId[i]);
+		}
+
+		rd.stats.textureBinds += rd.texturesCount;
+		break;
+	}
+	}
+}
+
+static void EndQuadsBatch(FlushReason reason)
+{
+	if (rd.quadsCount > 0)
+	{
+		CountFlush(reason);
+
+		rd.stats.quads += rd.quadsCount;
+		rd.stats.vertices += (IsVertexPulling() ? 6 : 4) * rd.quadsCount;
+		rd.stats.bytesUploaded += UsesQuadRecords() ? rd.quadsCount * sizeof(QuadInstance) : 4 * rd.quadsCount * sizeof(QuadVertex);
+
+		if (!rd.multiDrawIndirect)
+			rd.stats.drawCalls++;
+	}
+
+	if (rd.quadsCount > 0 && rd.multiDrawIndirect)
+	{
+		// only record the draw, the batches of the region are submitted together
+
+		DrawElementsIndirectCommand command;
+
+		if (IsInstanced())
+			command = { 6, (unsigned int)rd.quadsCount, 0, 0, (unsigned int)(rd.quadsVB.GetRegionOffset() / sizeof(QuadInstance)) + rd.quadsRegionUsed };
+		else
+			command = { 6 * (unsigned int)rd.quadsCount, 1, 0, (int)(rd.quadsVB.GetRegionOffset() / sizeof(QuadVertex)) + 4 * rd.quadsRegionUsed, 0 };
+
+		rd.indirectCommands.push_back(command);
+
+		if (rd.textureBinding == TextureBindingMode::SLOTS)
+			rd.drawTextureHandles.insert(rd.drawTextureHandles.end(), rd.slotHandles, rd.slotHandles + 32);
+
+		rd.quadsRegionUsed += rd.quadsCount;
+		SetQuadsWritePointer();
+	}
+	else if (rd.quadsCount > 0)
+	{
+		rd.gpuProfiler.Begin("Quads");
+
+		// bind shader
+		
+		rd.quadsShader->Bind();
+		UpdateCameraUniforms();
+
+		// bind textures
+
+		BindQuadsTextures();
+
+		// bind vertex array
+
+		rd.quadsVA.Bind();
+
+		if (IsVertexPulling())
+		{
+			// append the records after the ones of the previous batches so the draws still reading them do
+			// not make the upload wait, a full buffer is orphaned (or grown) and written from the start
+
+			size_t size = rd.quadsCount * sizeof(QuadInstance);
+			size_t offset = rd.pulledQuadsUsed * sizeof(QuadInstance);
+
+			if (offset + size > rd.pulledQuadsSB.GetSize())
+			{
+				if (rd.pulledQuadsSB.GetSize() < size)
+					rd.pulledQuadsSB.Create(rd.quadsCapacity * sizeof(QuadInstance));
+				else
+					rd.pulledQuadsSB.Orphan();
+
+				rd.pulledQuadsUsed = 0;
+				offset = 0;
+			}
+
+			rd.pulledQuadsSB.SetData(offset, size, rd.quadsID);
+			rd.pulledQuadsSB.Bind(1);
+
+			// gl_VertexID starts at the first vertex, the shader finds the records of this batch with it
+
+			glDrawArrays(GL_TRIANGLES, 6 * rd.pulledQuadsUsed, 6 * rd.quadsCount);
+
+			rd.pulledQuadsUsed += rd.quadsCount;
+		}
+		else if (rd.specification.streamingBuffers)
+		{
+			// bind index buffer
+
+			rd.quadsIB.Bind();
+
+			// the vertices are already in the mapped region, draw them where they are
+
+			if (IsInstanced())
+			{
+				int baseInstance = (int)(rd.quadsVB.GetRegionOffset() / sizeof(QuadInstance)) + rd.quadsRegionUsed;
+
+				glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, rd.quadsCount, baseInstance);
+			}
+			else
+			{
+				int baseVertex = (int)(rd.quadsVB.GetRegionOffset() / sizeof(QuadVertex)) + 4 * rd.quadsRegionUsed;
+
+				glDrawElementsBaseVertex(GL_TRIANGLES, 6 * rd.quadsCount, GL_UNSIGNED_INT, nullptr, baseVertex);
+			}
+
+			// the next batch continues after this one in the same region
+
+			rd.quadsRegionUsed += rd.quadsCount;
+			SetQuadsWritePointer();
+		}
+		else
+		{
+			// bind index buffer
+
+			rd.quadsIB.Bind();
+
+			// bind quads_vbo and set data
+
+			rd.quadsVB.Bind();
+
+			if (IsInstanced())
+			{
+				rd.quadsVB.SetData(rd.quadsCount * sizeof(QuadInstance), rd.quadsID);
+
+				glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr, rd.quadsCount);
+			}
+			else
+			{
+				rd.quadsVB.SetData(4 * rd.quadsCount * sizeof(QuadVertex), rd.quadsVD);
+
+				// draw call
+
+				glDrawElements(GL_TRIANGLES, 6 * rd.quadsCount, GL_UNSIGNED_INT, nullptr);
+			}
+		}
+
+		rd.gpuProfiler.End();
+	}
+
+	// reset
+
+	rd.quadsCount = 0;
+	rd.texturesCount = 0;
+	// memset(rd.texturesId, 0, rd.textureSlots * sizeof(unsigned int));
+
+	// the texture slots of this batch expire
+
+	if (rd.textureBinding == TextureBindingMode::SLOTS)
+		rd.texturesGeneration++;
+
+	// move to the next region once the current one is full
+
+	if (rd.quadsVB.IsStreaming() && rd.quadsCapacity <= 0)
+		NextQuadsRegion();
+}
+
+static void SubmitIndirectQuads()
+{
+	if (rd.indirectCommands.empty())
+		return;
+
+	rd.gpuProfiler.Begin("Quads (indirect)");
+
+	rd.quadsShader->Bind();
+	UpdateCameraUniforms();
+
+	BindQuadsTextures();
+
+	rd.quadsVA.Bind();
+	rd.quadsIB.Bind();
+
+	// upload the commands and draw every batch recorded since the last submission
+
+	size_t size = rd.indirectCommands.size() * sizeof(DrawElementsIndirectCommand);
+
+	if (rd.indirectBuffer.GetSize() < size)
+		rd.indirectBuffer.Create(2 * size);
+
+	rd.indirectBuffer.SetData(size, rd.indirectCommands.data());
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)rd.indirectCommands.size(), 0);
+
+	rd.stats.drawCalls++;
+	rd.stats.bytesUploaded += size;
+
+	rd.gpuProfiler.End();
+
+	rd.indirectCommands.clear();
+	rd.drawTextureHandles.clear();
+}
+
+static void FlushQuads(FlushReason reason)
+{
+	EndQuadsBatch(reason);
+	SubmitIndirectQuads();
+}
+
+static void FlushLines(FlushReason reason)
+{
+	if (rd.linesCount > 0)
+	{
+		CountFlush(reason);
+
+		rd.stats.drawCalls++;
+		rd.stats.vertices += 2 * rd.linesCount;
+		rd.stats.bytesUploaded += 2 * rd.linesCount * sizeof(LineVertex);
+
+		rd.gpuProfiler.Begin("Lines");
+
+		// bind shader and camera
+
+		rd.linesShader->Bind();
+		UpdateCameraUniforms();
+
+		// bind vertex array
+
+		rd.linesVA.Bind();
+
+		if (rd.specification.streamingBuffers)
+		{
+			int first = (int)(rd.linesVB.GetRegionOffset() / sizeof(LineVertex)) + 2 * rd.linesRegionUsed;
+
+			glDrawArrays(GL_LINES, first, 2 * rd.linesCount);
+
+			rd.linesRegionUsed += rd.linesCount;
+			rd.linesVD = rd.linesRegion + 2 * rd.linesRegionUsed;
+			rd.linesCapacity = rd.MAX_LINES - rd.linesRegionUsed;
+		}
+		else
+		{
+			// set vertex buffer data
+
+			rd.linesVB.Bind();
+			rd.linesVB.SetData(2 * rd.linesCount * sizeof(LineVertex), rd.linesVD);
+
+			// draw call
+
+			glDrawArrays(GL_LINES, 0, 2 * rd.linesCount);
+		}
+
+		rd.gpuProfiler.End();
+	}
+
+	rd.linesCount = 0;
+
+	if (rd.specification.streamingBuffers && rd.linesCapacity <= 0)
+		NextLinesRegion();
+}
+
+static int GetBindlessIndex(const Texture* texture)
+{
+	// append the handle to the storage buffer the first time the texture is drawn
+
+	int index = (int)rd.textureHandles.size();
+
+	rd.textureHandles.push_back(texture->GetBindlessHandle());
+
+	if (rd.textureHandles.size() * sizeof(uint64_t) > rd.textureHandlesSB.GetSize())
+	{
+		// the new buffer is twice the size, only the handles there are get copied to it
+
+		size_t size = rd.textureHandles.size() * sizeof(uint64_t);
+
+		rd.textureHandlesSB.Create(2 * rd.textureHandlesSB.GetSize());
+		rd.textureHandlesSB.SetData(0, size, rd.textureHandles.data());
+
+		rd.stats.bytesUploaded += size;
+	}
+	else
+	{
+		rd.textureHandlesSB.SetData(index * sizeof(uint64_t), sizeof(uint64_t), &rd.textureHandles[index]);
+
+		rd.stats.bytesUploaded += sizeof(uint64_t);
+	}
+
+	texture->SetRendererIndex(index, rd.texturesGeneration);
+
+	return index;
+}
+
+static bool IsTextureArrayOf(const TextureArray& textureArray, const Texture* texture)
+{
+	return textureArray.width == texture->GetWidth() && textureArray.height == texture->GetHeight() && textureArray.format == texture->GetInternalFormat() &&
+		textureArray.levels == texture->GetLevels();
+}
+
+static void CopyToTextureArray(TextureArray& textureArray, int layer, const Texture* texture)
+{
+	// every level is copied, the mips of the textures are built in linear light and generating them in the
+	// array would average the srgb values
+
+	for (int level = 0; level < textureArray.levels; level++)
+	{
+		int width = std::max(textureArray.width >> level, 1);
+		int height = std::max(textureArray.height >> level, 1);
+
+		glCopyImageSubData(texture->GetId(), GL_TEXTURE_2D, level, 0, 0, 0, textureArray.id, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1);
+	}
+
+	textureArray.layerTextures[layer] = texture->GetId();
+	textureArray.layerRevisions[layer] = texture->GetRevision();
+}
+
+static void CreateTextureArray(TextureArray& textureArray, int capacity)
+{
+	unsigned int oldId = textureArray.id;
+
+	glGenTextures(1, &textureArray.id);
+	RenderState::BindTexture(GL_TEXTURE_2D_ARRAY, textureArray.id);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, textureArray.levels, textureArray.format, textureArray.width, textureArray.height, capacity);
+
+	// when growing keep the layers already copied
+
+	if (oldId != 0)
+	{
+		for (int level = 0; level < textureArray.levels; level++)
+		{
+			int width = std::max(textureArray.width >> level, 1);
+			int height = std::max(textureArray.height >> level, 1);
+
+			glCopyImageSubData(oldId, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, textureArray.id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, width, height, textureArray.layersCount);
+		}
+
+		RenderState::ForgetTexture(oldId);
+		glDeleteTextures(1, &oldId);
+	}
+
+	textureArray.capacity = capacity;
+	textureArray.layerTextures.resize(capacity, 0);
+	textureArray.layerRevisions.resize(capacity, 0);
+}
+
+static int GetTextureArrayIndex(const Texture* texture)
+{
+	// already in a layer, copy it again only if its pixels changed
+
+	if (texture->GetRendererGeneration() == rd.texturesGeneration)
+	{
+		int index = texture->GetRendererIndex();
+		auto& textureArray = rd.textureArrays[index >> 16];
+		int layer = index & 0xFFFF;
+
+		if (textureArray.layerTextures[layer] == texture->GetId() && textureArray.layerRevisions[layer] == texture->GetRevision())
+			return index;
+
+		CopyToTextureArray(textureArray, layer, texture);
+
+		return index;
+	}
+
+	// find the array of the texture size (there are as many arrays as texture units at most)
+
+	int arrayIndex = -1;
+
+	for (int i = 0; i < (int)rd.textureArrays.size(); i++)
+	{
+		auto& textureArray = rd.textureArrays[i];
+
+		if (IsTextureArrayOf(textureArray, texture) && textureArray.layersCount < rd.maxArrayLayers)
+		{
+			arrayIndex = i;
+			break;
+		}
+	}
+
+	if (arrayIndex == -1)
+	{
+		// out of texture units, draw what was batched and start over with empty arrays
+
+		if ((int)rd.textureArrays.size() >= rd.textureSlots)
+		{
+			std::cout << "[WARNING] Texture arrays exhausted, resetting them" << std::endl;
+
+			FlushQuads(FlushReason::TEXTURE_SLOTS);
+
+			for (auto& textureArray : rd.textureArrays)
+			{
+				RenderState::ForgetTexture(textureArray.id);
+				glDeleteTextures(1, &textureArray.id);
+			}
+
+			rd.textureArrays.clear();
+			rd.texturesGeneration++;
+		}
+
+		TextureArray textureArray = {};
+		textureArray.width = texture->GetWidth();
+		textureArray.height = texture->GetHeight();
+		textureArray.format = texture->GetInternalFormat();
+		textureArray.levels = texture->GetLevels();
+
+		CreateTextureArray(textureArray, std::min(16, rd.maxArrayLayers));
+
+		arrayIndex = (int)rd.textureArrays.size();
+		rd.textureArrays.push_back(std::move(textureArray));
+	}
+
+	auto& textureArray = rd.textureArrays[arrayIndex];
+
+	if (textureArray.layersCount >= textureArray.capacity)
+		CreateTextureArray(textureArray, std::min(2 * textureArray.capacity, rd.maxArrayLayers));
+
+	int layer = textureArray.layersCount++;
+
+	CopyToTextureArray(textureArray, layer, texture);
+
+	// the array index goes in the high bits and the layer in the low bits
+
+	int index = (arrayIndex << 16) | layer;
+
+	texture->SetRendererIndex(index, rd.texturesGeneration);
+
+	return index;
+}
+
+static bool TextureNeedsNewBatch(const Texture* texture)
+{
+	// true when getting the slot of the texture would flush the current batch
+
+	if (texture->GetRendererGeneration() == rd.texturesGeneration)
+		return false;
+
+	switch (rd.textureBinding)
+	{
+	case TextureBindingMode::SLOTS:
+		return rd.texturesCount >= rd.textureSlots;
+	case TextureBindingMode::ARRAY:
+	{
+		for (const auto& textureArray : rd.textureArrays)
+		{
+			if (IsTextureArrayOf(textureArray, texture) && textureArray.layersCount < rd.maxArrayLayers)
+				return false;
+		}
+
+		return (int)rd.textureArrays.size() >= rd.textureSlots;
+	}
+	default:
+		return false;
+	}
+}
+
+static int GetTextureSlot(const Texture* texture)
+{
+	// mips of the rows written since the texture was last drawn (the atlas pages)
+
+	if (texture->HasPendingMips())
+		texture->UpdateMips();
+
+	// the index stored on the texture is still valid
+
+	if (texture->GetRendererGeneration() == rd.texturesGeneration && rd.textureBinding != TextureBindingMode::ARRAY)
+		return texture->GetRendererIndex();
+
+	switch (rd.textureBinding)
+	{
+	case TextureBindingMode::BINDLESS:
+		return GetBindlessIndex(texture);
+	case TextureBindingMode::ARRAY:
+		return GetTextureArrayIndex(texture);
+	default:
+		break;
+	}
+
+	// take the next free slot of this batch
+
+	int slot = rd.texturesCount++;
+
+	rd.texturesId[slot] = texture->GetId();
+
+	if (rd.multiDrawIndirect)
+		rd.slotHandles[slot] = texture->GetBindlessHandle();
+	texture->SetRendererIndex(slot, rd.texturesGeneration);
+
+	return slot;
+}
+
+/* quads and lines */
+
+static void WriteQuadCorners(QuadVertex* vertices, const glm::vec2* corners, const glm::vec4& textureRect, const glm::vec4& color, uint32_t textureId);
+
+static void WriteQuadVertices(QuadVertex* vertices, const glm::vec2& center, const glm::vec2& size, float radians, const glm::vec4& textureRect, const glm::vec4& color, uint32_t textureId)
+{
+	// corners of the quad (the uv of each corner is textureRect.xy + (corner + 0.5) * textureRect.zw)
+
+	glm::vec2 halfSize = size * 0.5f;
+	glm::vec2 corners[4];
+
+	if (radians == 0.0f)
+	{
+		corners[0] = { center.x - halfSize.x, center.y - halfSize.y };
+		corners[1] = { center.x + halfSize.x, center.y - halfSize.y };
+		corners[2] = { center.x + halfSize.x, center.y + halfSize.y };
+		corners[3] = { center.x - halfSize.x, center.y + halfSize.y };
+	}
+	else
+	{
+		// rotate the half size axes instead of transforming a unit quad with matrices
+
+		float c = std::cos(radians);
+		float s = std::sin(radians);
+
+		glm::vec2 axisX = { halfSize.x * c, halfSize.x * s };
+		glm::vec2 axisY = { -halfSize.y * s, halfSize.y * c };
+
+		corners[0] = center - axisX - axisY;
+		corners[1] = center + axisX - axisY;
+		corners[2] = center + axisX + axisY;
+		corners[3] = center - axisX + axisY;
+	}
+
+	WriteQuadCorners(vertices, corners, textureRect, color, textureId);
+}
+
+static void WriteQuadCorners(QuadVertex* vertices, const glm::vec2* corners, const glm::vec4& textureRect, const glm::vec4& color, uint32_t textureId)
+{
+	float u0 = textureRect.x;
+	float v0 = textureRect.y;
+	float u1 = textureRect.x + textureRect.z;
+	float v1 = textureRect.y + textureRect.w;
+
+	// set the vertex data (position, texture id, texture uv, color), the color is packed once for the four vertices
+
+	Unorm8x4 packedColor(color);
+
+	vertices[0] = { corners[0], textureId, { u0, v0 }, packedColor };
+	vertices[1] = { corners[1], textureId, { u1, v0 }, packedColor };
+	vertices[2] = { corners[2], textureId, { u1, v1 }, packedColor };
+	vertices[3] = { corners[3], textureId, { u0, v1 }, packedColor };
+}
+
+static void PushQuad(const Texture* texture, const glm::vec2& center, const glm::vec2& size, float radians, const glm::vec4& textureRect, const glm::vec4& color)
+{
+	// check if it needs to make a new batch
+
+	bool full = rd.quadsCount >= rd.quadsCapacity && !GrowPulledQuads();
+
+	if (full || rd.texturesCount >= rd.textureSlots)
+		EndQuadsBatch(full ? FlushReason::CAPACITY : FlushReason::TEXTURE_SLOTS);
+
+	// get texture slot
+
+	int slot = GetTextureSlot(texture);
+
+	// instanced and vertex pulling, a single record for the whole quad and the rotation is applied by the vertex shader
+
+	if (UsesQuadRecords())
+	{
+		rd.quadsID[rd.quadsCount] = { center, size, radians, (float)slot, textureRect, color };
+		rd.quadsCount++;
+
+		return;
+	}
+
+	// four vertices transformed on the cpu
+
+	WriteQuadVertices(rd.quadsVD + 4 * rd.quadsCount, center, size, radians, textureRect, color, (uint32_t)slot);
+
+	// increment the number of quads
+
+	rd.quadsCount++;
+}
+
+static void PushQuadCorners(const Texture* texture, const glm::vec2* corners, const glm::vec4& color)
+{
+	// batched mode only, the four corners can be any quadrilateral (or a triangle with the last two equal)
+
+	if (rd.quadsCount >= rd.quadsCapacity || rd.texturesCount >= rd.textureSlots)
+		EndQuadsBatch(rd.quadsCount >= rd.quadsCapacity ? FlushReason::CAPACITY : FlushReason::TEXTURE_SLOTS);
+
+	int slot = GetTextureSlot(texture);
+
+	WriteQuadCorners(rd.quadsVD + 4 * rd.quadsCount, corners, { 0.0f, 0.0f, 1.0f, 1.0f }, color, (uint32_t)slot);
+
+	rd.quadsCount++;
+}
+
+static void PushLine(const glm::vec2& p1, const glm::vec2& p2, const glm::vec4& color)
+{
+	if (rd.linesCount >= rd.linesCapacity)
+		FlushLines(FlushReason::CAPACITY);
+
+	unsigned int index = rd.linesCount * 2;
+
+	Unorm8x4 packedColor(color);
+
+	rd.linesVD[index] = { p1, packedColor };
+	rd.linesVD[index + 1] = { p2, packedColor };
+
+	rd.linesCount++;
+}
+
+/* deferred commands */
+
+static uint64_t MakeSortKey(CommandPipeline pipeline, unsigned int textureId)
+{
+	// layer | blend mode | pipeline | texture | sequence, from the most to the least significant bits
+
+	uint64_t layer = (uint64_t)(rd.layer + 128) & 0xFF;
+	uint64_t blendMode = (uint64_t)rd.blendMode & 0xF;
+
+	return (layer << 56) | (blendMode << 52) | ((uint64_t)pipeline << 48) | ((uint64_t)(textureId & 0xFFFF) << 32) | rd.commandsSequence++;
+}
+
+static int CountStateChanges(const std::vector<DrawCommand>& commands)
+{
+	// blend mode, pipeline and texture, the layer and sequence are not gpu state
+
+	int stateChanges = 0;
+	uint64_t previousState = ~0ull;
+
+	for (const auto& command : commands)
+	{
+		uint64_t state = (command.key >> 32) & 0xFFFFFF;
+
+		if (state != previousState)
+			stateChanges++;
+
+		previousState = state;
+	}
+
+	return stateChanges;
+}
+
+static void RadixSort(std::vector<DrawCommand>& commands, std::vector<DrawCommand>& temp)
+{
+	// lsd radix sort on the 64 bit keys, 8 bits per pass (stable so the sequence order is kept)
+
+	size_t n = commands.size();
+
+	temp.resize(n);
+
+	DrawCommand* src = commands.data();
+	DrawCommand* dst = temp.data();
+
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = {};
+
+		for (size_t i = 0; i < n; i++)
+			counts[(src[i].key >> shift) & 0xFF]++;
+
+		// skip the pass if every key has the same byte
+
+		if (counts[(src[0].key >> shift) & 0xFF] == n)
+			continue;
+
+		size_t offset = 0;
+
+		for (int b = 0; b < 256; b++)
+		{
+			size_t count = counts[b];
+			counts[b] = offset;
+			offset += count;
+		}
+
+		for (size_t i = 0; i < n; i++)
+			dst[counts[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if (src != commands.data())
+		std::copy(src, src + n, commands.data());
+}
+
+// always goes to RenderState, its cache decides what reaches gl so a blend state changed behind the
+// renderer (through RenderState or followed by RenderState::Invalidate) is set again
+
+static void ApplyBlendMode(BlendMode blendMode)
+{
+	switch (blendMode)
+	{
+	case BlendMode::NONE:
+		RenderState::SetBlend(false);
+		break;
+	case BlendMode::ALPHA:
+		RenderState::SetBlend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		break;
+	case BlendMode::ADDITIVE:
+		RenderState::SetBlend(true, GL_SRC_ALPHA, GL_ONE);
+		break;
+	case BlendMode::MULTIPLY:
+		RenderState::SetBlend(true, GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
+		break;
+	case BlendMode::PREMULTIPLIED_ALPHA:
+		RenderState::SetBlend(true, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+		break;
+	}
+
+	rd.appliedBlendMode = blendMode;
+}
+
+static void FlushCommands()
+{
+	if (rd.commands.empty())
+		return;
+
+	// sort the commands by their keys
+
+	rd.commandQueueStats.commands = (int)rd.commands.size();
+	rd.commandQueueStats.stateChangesSubmitted = CountStateChanges(rd.commands);
+
+	RadixSort(rd.commands, rd.commandsTemp);
+
+	rd.commandQueueStats.stateChangesSorted = CountStateChanges(rd.commands);
+	rd.commandQueueStats.stateChangesSaved = rd.commandQueueStats.stateChangesSubmitted - rd.commandQueueStats.stateChangesSorted;
+
+	// replay them, consecutive commands with the same state end up in the same batch
+
+	// the blend mode of the first command is applied even when it matches the last one
+
+	if (!rd.commands.empty())
+		ApplyBlendMode((BlendMode)((rd.commands.front().key >> 52) & 0xF));
+
+	for (const auto& command : rd.commands)
+	{
+		BlendMode blendMode = (BlendMode)((command.key >> 52) & 0xF);
+		CommandPipeline pipeline = (CommandPipeline)((command.key >> 48) & 0xF);
+
+		if (blendMode != rd.appliedBlendMode)
+		{
+			FlushQuads(FlushReason::STATE_CHANGE);
+			FlushLines(FlushReason::STATE_CHANGE);
+			ApplyBlendMode(blendMode);
+		}
+
+		if (pipeline == CommandPipeline::QUADS)
+		{
+			// keep the order between the quads and the lines
+
+			if (rd.linesCount > 0)
+				FlushLines(FlushReason::STATE_CHANGE);
+
+			const auto& quad = rd.quadCommands[command.index];
+
+			PushQuad(quad.texture, quad.position, quad.size, quad.rotation, quad.textureRect, quad.color);
+		}
+		else
+		{
+			if (rd.quadsCount > 0)
+				FlushQuads(FlushReason::STATE_CHANGE);
+
+			const auto& line = rd.lineCommands[command.index];
+
+			PushLine(line.p1, line.p2, line.color);
+		}
+	}
+
+	rd.commands.clear();
+	rd.quadCommands.clear();
+	rd.lineCommands.clear();
+	rd.commandsSequence = 0;
+}
+
+static bool IsQuadVisible(const glm::vec2& center, const glm::vec2& size, float radians)
+{
+	if (!rd.specification.culling)
+		return true;
+
+	// rotated quads are tested with the bounds of their circumscribed circle, it saves the sin and cos
+
+	glm::vec2 halfSize = glm::abs(size) * 0.5f;
+
+	if (radians != 0.0f)
+		halfSize = glm::vec2(glm::length(halfSize));
+
+	return Rect{ center - halfSize, center + halfSize }.Overlaps(rd.camera.GetVisibleRect());
+}
+
+static void SubmitQuad(const Texture* texture, const glm::vec2& center, const glm::vec2& size, float radians, const glm::vec4& textureRect, const glm::vec4& color)
+{
+	if (!IsQuadVisible(center, size, radians))
+		return;
+
+	if (rd.specification.deferred)
+	{
+		rd.commands.push_back({ MakeSortKey(CommandPipeline::QUADS, texture->GetId()), (uint32_t)rd.quadCommands.size() });
+		rd.quadCommands.push_back({ texture, center, size, radians, textureRect, color });
+	}
+	else
+		PushQuad(texture, center, size, radians, textureRect, color);
+}
+
+static bool IsTriangleLines()
+{
+	return rd.specification.lineMode == LineRenderMode::TRIANGLES;
+}
+
+static bool IsSegmentVisible(const glm::vec2& p1, const glm::vec2& p2, float halfWidth)
+{
+	if (!rd.specification.culling)
+		return true;
+
+	return Rect{ glm::min(p1, p2) - halfWidth, glm::max(p1, p2) + halfWidth }.Overlaps(rd.camera.GetVisibleRect());
+}
+
+static void SubmitSegment(const glm::vec2& p1, const glm::vec2& p2, float width, const glm::vec4& color)
+{
+	glm::vec2 direction = p2 - p1;
+	float length = glm::length(direction);
+
+	if (length == 0.0f)
+		return;
+
+	// deferred and record modes take the segment as a rotated quad
+
+	if (rd.specification.deferred || UsesQuadRecords())
+	{
+		SubmitQuad(rd.whiteTexture.get(), (p1 + p2) * 0.5f, { length, width }, std::atan2(direction.y, direction.x), { 0.0f, 0.0f, 1.0f, 1.0f }, color);
+		return;
+	}
+
+	// batched mode writes the corners directly, no trigonometry
+
+	glm::vec2 offset = glm::vec2(-direction.y, direction.x) * (width * 0.5f / length);
+	glm::vec2 corners[4] = { p1 - offset, p2 - offset, p2 + offset, p1 + offset };
+
+	PushQuadCorners(rd.whiteTexture.get(), corners, color);
+}
+
+static void SubmitLine(const glm::vec2& p1, const glm::vec2& p2, float width, const glm::vec4& color)
+{
+	// culled in every mode, GL_LINES are about a pixel wide whatever the width
+
+	if (!IsSegmentVisible(p1, p2, IsTriangleLines() ? width * 0.5f : 0.5f))
+		return;
+
+	rd.stats.lines++;
+
+	if (IsTriangleLines())
+		SubmitSegment(p1, p2, width, color);
+	else if (rd.specification.deferred)
+	{
+		rd.commands.push_back({ MakeSortKey(CommandPipeline::LINES, 0), (uint32_t)rd.lineCommands.size() });
+		rd.lineCommands.push_back({ p1, p2, width, color });
+	}
+	else
+		PushLine(p1, p2, color);
+}
+
+static glm::vec4 GetTextureRect(const Texture* texture, const glm::vec2& srcPosition, const glm::vec2& srcSize)
+{
+	// normalize the srcPosition and srcSize (v is flipped, the textures are loaded upside down)
+
+	glm::vec2 srcPositionNormalized = { srcPosition.x / (float)texture->GetWidth(), srcPosition.y / (float)texture->GetHeight() };
 	glm::vec2 srcSizeNormalized = { srcSize.x / (float)texture->GetWidth(), srcSize.y / (float)texture->GetHeight() };
 
-	// transformation
+	return { srcPositionNormalized.x, 1 - srcPositionNormalized.y, srcSizeNormalized.x, -srcSizeNormalized.y };
+}
+
+static void FlushAll(FlushReason reason)
+{
+	FlushCommands();
+
+	FlushQuads(reason);
+
+	FlushLines(reason);
+}
+
+void Renderer::Flush()
+{
+	FlushAll(FlushReason::EXPLICIT);
+}
+
+void Renderer::SetCamera(const OrthoCamera& camera)
+{
+	FlushAll(FlushReason::STATE_CHANGE);
+
+	rd.camera = camera;
+	rd.cameraUniformsDirty = true;
+}
+
+const OrthoCamera& Renderer::GetCamera()
+{
+	return rd.camera;
+}
+
+void Renderer::SetLayer(int layer)
+{
+	rd.layer = glm::clamp(layer, -128, 127);
+}
+
+void Renderer::SetBlendMode(BlendMode blendMode)
+{
+	// in immediate mode the batches drawn so far keep the previous blend mode, the same mode is applied
+	// again without flushing in case the gl state was changed since
+
+	if (!rd.specification.deferred)
+	{
+		if (blendMode != rd.appliedBlendMode)
+		{
+			FlushQuads(FlushReason::STATE_CHANGE);
+			FlushLines(FlushReason::STATE_CHANGE);
+		}
+
+		ApplyBlendMode(blendMode);
+	}
+
+	rd.blendMode = blendMode;
+}
+
+const CommandQueueStats& Renderer::GetCommandQueueStats()
+{
+	return rd.commandQueueStats;
+}
+
+void Renderer::BeginFrame()
+{
+	rd.stats = RendererStats();
+	RenderState::ResetStats();
+
+	// frame constants
+
+	auto now = std::chrono::steady_clock::now();
+
+	rd.cameraUniforms.time = std::chrono::duration<float>(now - rd.startTime).count();
+	rd.cameraUniforms.deltaTime = std::chrono::duration<float>(now - rd.frameTime).count();
+	rd.cameraUniformsDirty = true;
+	rd.frameTime = now;
+
+	rd.gpuProfiler.BeginFrame();
+}
+
+static void AddStats(RendererStats& sum, const RendererStats& stats)
+{
+	sum.drawCalls += stats.drawCalls;
+	sum.quads += stats.quads;
+	sum.lines += stats.lines;
+	sum.vertices += stats.vertices;
+	sum.bytesUploaded += stats.bytesUploaded;
+	sum.textureBinds += stats.textureBinds;
+	sum.stateCallsElided += stats.stateCallsElided;
+	sum.uniformsElided += stats.uniformsElided;
+	sum.flushesCapacity += stats.flushesCapacity;
+	sum.flushesTextureSlots += stats.flushesTextureSlots;
+	sum.flushesStateChange += stats.flushesStateChange;
+	sum.flushesExplicit += stats.flushesExplicit;
+}
+
+static void WriteStats()
+{
+	// average per frame of the interval
+
+	auto now = std::chrono::steady_clock::now();
+	double time = std::chrono::duration<double>(now - rd.statsStart).count();
+	double frames = (double)rd.statsFrames;
+	const RendererStats& sum = rd.statsSum;
+
+	double values[] = {
+		sum.drawCalls / frames, sum.quads / frames, sum.lines / frames, sum.vertices / frames,
+		sum.bytesUploaded / frames, sum.textureBinds / frames, sum.stateCallsElided / frames,
+		sum.uniformsElided / frames, sum.flushesCapacity / frames,
+		sum.flushesTextureSlots / frames, sum.flushesStateChange / frames, sum.flushesExplicit / frames
+	};
+
+	static const char* names[] = {
+		"draw_calls", "quads", "lines", "vertices", "bytes_uploaded", "texture_binds",
+		"state_calls_elided", "uniforms_elided",
+		"flushes_capacity", "flushes_texture_slots", "flushes_state_change", "flushes_explicit"
+	};
+
+	if (rd.statsFormat == StatsExportFormat::CSV)
+	{
+		rd.statsFile << time << ',' << rd.statsFrames;
+
+		for (double value : values)
+			rd.statsFile << ',' << value;
+
+		rd.statsFile << '\n';
+	}
+	else
+	{
+		rd.statsFile << "{\"time\":" << time << ",\"frames\":" << rd.statsFrames;
+
+		for (int i = 0; i < (int)(sizeof(values) / sizeof(values[0])); i++)
+			rd.statsFile << ",\"" << names[i] << "\":" << values[i];
+
+		rd.statsFile << "}\n";
+	}
+
+	rd.statsFile.flush();
+
+	rd.statsSum = RendererStats();
+	rd.statsFrames = 0;
+	rd.statsLastWrite = now;
+}
+
+void Renderer::EndFrame()
+{
+	rd.gpuProfiler.EndFrame();
+
+	rd.stats.stateCallsElided = RenderState::GetStats().elided;
+	rd.stats.uniformsElided = RenderState::GetStats().uniformsElided;
+	rd.lastFrameStats = rd.stats;
+
+	// export
+
+	if (rd.statsFile.is_open())
+	{
+		AddStats(rd.statsSum, rd.stats);
+		rd.statsFrames++;
+
+		if (std::chrono::duration<float>(std::chrono::steady_clock::now() - rd.statsLastWrite).count() >= rd.statsInterval)
+			WriteStats();
+	}
+}
+
+void Renderer::BeginGpuScope(const char* label)
+{
+	rd.gpuProfiler.Begin(label);
+}
+
+void Renderer::EndGpuScope()
+{
+	rd.gpuProfiler.End();
+}
+
+GpuProfiler& Renderer::GetGpuProfiler()
+{
+	return rd.gpuProfiler;
+}
+
+const RendererStats& Renderer::GetStats()
+{
+	return rd.lastFrameStats;
+}
+
+bool Renderer::StartStatsExport(const std::string& path, StatsExportFormat format, float intervalSeconds)
+{
+	StopStatsExport();
+
+	rd.statsFile.open(path, std::ios::out | std::ios::trunc);
+
+	if (!rd.statsFile.is_open())
+	{
+		std::cout << "[ERROR] Can't open the stats file " << path << std::endl;
+		return false;
+	}
+
+	rd.statsFormat = format;
+	rd.statsInterval = intervalSeconds;
+	rd.statsStart = std::chrono::steady_clock::now();
+	rd.statsLastWrite = rd.statsStart;
+	rd.statsSum = RendererStats();
+	rd.statsFrames = 0;
+
+	if (format == StatsExportFormat::CSV)
+		rd.statsFile << "time,frames,draw_calls,quads,lines,vertices,bytes_uploaded,texture_binds,state_calls_elided,uniforms_elided,flushes_capacity,flushes_texture_slots,flushes_state_change,flushes_explicit\n";
+
+	return true;
+}
+
+void Renderer::StopStatsExport()
+{
+	if (!rd.statsFile.is_open())
+		return;
+
+	// the frames since the last write
+
+	if (rd.statsFrames > 0)
+		WriteStats();
+
+	rd.statsFile.close();
+}
+
+void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec4& color)
+{
+	if (texture == nullptr)
+		return;
+
+	DrawTexture(texture, position, { texture->GetWidth(), texture->GetHeight() }, color);
+}
+
+void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+	if (texture == nullptr)
+		return;
+
+	DrawTexture(texture, position, size, { 0, 0 }, { texture->GetWidth(), texture->GetHeight() }, color);
+}
 
-	glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(position, 0.0f)) * glm::rotate(glm::mat4(1.0f), radians, { 0.0f, 0.0f, 1.0f }) * glm::scale(glm::mat4(1.0f), glm::vec3(size, 0.0f));
+void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPosition, const glm::vec2& srcSize, const glm::vec4& color)
+{
+	if (texture == nullptr)
+		return;
 
-	glm::vec4 normalQuad[4] = {
-		{-0.5f, -0.5f, 0.0f, 1.0f},
-		{ 0.5f, -0.5f, 0.0f, 1.0f},
-		{ 0.5f,  0.5f, 0.0f, 1.0f},
-		{-0.5f,  0.5f, 0.0f, 1.0f}
-	};
+	// the position is the top left corner
 
-	int index = rd.quadsCount * 4;
+	SubmitQuad(texture, position + size * 0.5f, size, 0.0f, GetTextureRect(texture, srcPosition, srcSize), color);
+}
 
-	rd.quadsVD[index]     = { transform * normalQuad[0], (float)slot, {srcPositionNormalized.x                        , 1 - (srcPositionNormalized.y)}, color };
-	rd.quadsVD[index + 1] = { transform * normalQuad[1], (float)slot, {srcPositionNormalized.x + srcSizeNormalized.x, 1 - (srcPositionNormalized.y)}, color };
-	rd.quadsVD[index + 2] = { transform * normalQuad[2], (float)slot, {srcPositionNormalized.x + srcSizeNormalized.x, 1 - (srcPositionNormalized.y + srcSizeNormalized.y)}, color };
-	rd.quadsVD[index + 3] = { transform * normalQuad[3], (float)slot, {srcPositionNormalized.x                        , 1 - (srcPositionNormalized.y + srcSizeNormalized.y)}, color };
+void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, float radians, const glm::vec4& color)
+{
+	if (texture == nullptr)
+		return;
 
-	rd.quadsCount++;
+	DrawTexture(texture, position, { texture->GetWidth(), texture->GetHeight() }, radians, color);
 }
 
-void Renderer::DrawLine(const glm::vec2& p1, const glm::vec2& p2, const glm::vec4& color)
+void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color)
 {
-	if (rd.linesCount >= rd.MAX_LINES)
-		FlushLines();
+	if (texture == nullptr)
+		return;
 
-	unsigned int index = rd.linesCount * 2;
+	DrawTexture(texture, position, size, { 0.0f, 0.0f }, { texture->GetWidth(), texture->GetHeight() }, radians, color);
+}
+
+void Renderer::DrawTexture(const Texture* texture, const glm::vec2& position, const glm::vec2& size, const glm::vec2& srcPosition, const glm::vec2& srcSize, float radians, const glm::vec4& color)
+{
+	if (texture == nullptr)
+		return;
 
-	rd.linesVD[index] = { p1, color };
-	rd.linesVD[index + 1] = { p2, color };
+	// the position is the center of the quad
 
-	rd.linesCount++;
+	SubmitQuad(texture, position, size, radians, GetTextureRect(texture, srcPosition, srcSize), color);
+}
+
+void Renderer::DrawTexture(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+	if (region.GetTexture() == nullptr)
+		return;
+
+	SubmitQuad(region.GetTexture(), position + size * 0.5f, size, 0.0f, region.GetTextureRect(), color);
+}
+
+void Renderer::DrawTexture(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color)
+{
+	if (region.GetTexture() == nullptr)
+		return;
+
+	SubmitQuad(region.GetTexture(), position, size, radians, region.GetTextureRect(), color);
+}
+
+// the bulk path takes sprite instances and recorded quad commands
+
+static const Texture* GetQuadTexture(const SpriteInstance& sprite) { return sprite.region != nullptr ? sprite.region->GetTexture() : nullptr; }
+static const Texture* GetQuadTexture(const QuadCommand& quad) { return quad.texture; }
+static const glm::vec4& GetQuadTextureRect(const SpriteInstance& sprite) { return sprite.region->GetTextureRect(); }
+static const glm::vec4& GetQuadTextureRect(const QuadCommand& quad) { return quad.textureRect; }
+
+template<typename T>
+static int GatherSpriteChunk(const T* sprites, size_t count, size_t* consumed)
+{
+	SpriteChunk& chunk = rd.spriteChunk;
+
+	int maxQuads = std::min(SpriteChunk::SIZE, rd.quadsCapacity - rd.quadsCount);
+	int n = 0;
+	size_t i = 0;
+
+	for (; i < count && n < maxQuads; i++)
+	{
+		const T& sprite = sprites[i];
+		const Texture* texture = GetQuadTexture(sprite);
+
+		if (texture == nullptr || !IsQuadVisible(sprite.position, sprite.size, sprite.rotation))
+			continue;
+
+		// stop before a texture that breaks the batch, the sprites gathered so far use the current slots
+
+		if (TextureNeedsNewBatch(texture))
+		{
+			if (n > 0)
+				break;
+
+			EndQuadsBatch(FlushReason::TEXTURE_SLOTS);
+		}
+
+		chunk.slots[n] = GetTextureSlot(texture);
+
+		chunk.textureRects[n] = &GetQuadTextureRect(sprite);
+		chunk.colors[n] = &sprite.color;
+		chunk.centerX[n] = sprite.position.x;
+		chunk.centerY[n] = sprite.position.y;
+		chunk.halfWidth[n] = sprite.size.x * 0.5f;
+		chunk.halfHeight[n] = sprite.size.y * 0.5f;
+		chunk.radians[n] = sprite.rotation;
+		n++;
+	}
+
+	*consumed = i;
+
+	return n;
+}
+
+static void WriteSpriteChunk(int n)
+{
+	SpriteChunk& chunk = rd.spriteChunk;
+	QuadVertex* vertices = rd.quadsVD + 4 * rd.quadsCount;
+
+	// positions with the simd kernels
+
+	bool rotated = false;
+
+	for (int i = 0; i < n && !rotated; i++)
+		rotated = chunk.radians[i] != 0.0f;
+
+	if (rotated)
+	{
+		SpriteKernels::SinCos(chunk.radians, n, chunk.sin, chunk.cos);
+		SpriteKernels::RotatedCorners(chunk.centerX, chunk.centerY, chunk.halfWidth, chunk.halfHeight, chunk.sin, chunk.cos, n, (float*)vertices, sizeof(QuadVertex) / sizeof(float));
+	}
+	else
+		SpriteKernels::AxisAlignedCorners(chunk.centerX, chunk.centerY, chunk.halfWidth, chunk.halfHeight, n, (float*)vertices, sizeof(QuadVertex) / sizeof(float));
+
+	// the rest of the attributes come straight from the regions
+
+	for (int i = 0; i < n; i++)
+	{
+		const glm::vec4& textureRect = *chunk.textureRects[i];
+		Unorm8x4 color(*chunk.colors[i]);
+		uint32_t slot = (uint32_t)chunk.slots[i];
+
+		float u0 = textureRect.x;
+		float v0 = textureRect.y;
+		float u1 = textureRect.x + textureRect.z;
+		float v1 = textureRect.y + textureRect.w;
+
+		QuadVertex* quad = vertices + 4 * i;
+
+		quad[0].textureId = slot; quad[0].textureUv = { u0, v0 }; quad[0].color = color;
+		quad[1].textureId = slot; quad[1].textureUv = { u1, v0 }; quad[1].color = color;
+		quad[2].textureId = slot; quad[2].textureUv = { u1, v1 }; quad[2].color = color;
+		quad[3].textureId = slot; quad[3].textureUv = { u0, v1 }; quad[3].color = color;
+	}
+
+	rd.quadsCount += n;
+}
+
+template<typename T>
+static void SubmitQuads(const T* sprites, size_t count)
+{
+	// deferred, instanced and vertex pulling modes take the sprites one by one, they only copy a record
+
+	if (rd.specification.deferred || UsesQuadRecords())
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			const T& sprite = sprites[i];
+			const Texture* texture = GetQuadTexture(sprite);
+
+			if (texture != nullptr)
+				SubmitQuad(texture, sprite.position, sprite.size, sprite.rotation, GetQuadTextureRect(sprite), sprite.color);
+		}
+
+		return;
+	}
+
+	// batched mode, vertices generated in chunks
+
+	while (count > 0)
+	{
+		if (rd.quadsCount >= rd.quadsCapacity)
+			EndQuadsBatch(FlushReason::CAPACITY);
+
+		size_t consumed;
+		int n = GatherSpriteChunk(sprites, count, &consumed);
+
+		WriteSpriteChunk(n);
+
+		sprites += consumed;
+		count -= consumed;
+	}
+}
+
+void Renderer::DrawSprites(const SpriteInstance* sprites, size_t count)
+{
+	SubmitQuads(sprites, count);
+}
+
+void Renderer::DrawSpatialGrid(const SpatialGrid& grid)
+{
+	rd.visibleSprites.clear();
+
+	grid.Query(rd.camera.GetVisibleRect(), rd.visibleSprites);
+
+	SubmitQuads(rd.visibleSprites.data(), rd.visibleSprites.size());
+}
+
+void Renderer::UploadStaticBatch(StaticBatch& batch)
+{
+	uint32_t count = batch.GetCount();
+
+	// grow the gpu buffers, everything is uploaded again
+
+	if (count > batch.m_capacity)
+	{
+		uint32_t capacity = std::max(batch.m_capacity * 2, count);
+
+		batch.m_vb = std::make_unique<VertexBuffer>();
+		batch.m_vb->Create(4 * capacity * sizeof(QuadVertex));
+
+		batch.m_ib = std::make_unique<IndexBuffer>();
+		CreateQuadsIndexBuffer(*batch.m_ib, capacity);
+
+		batch.m_va = std::make_unique<VertexArray>();
+		batch.m_va->Create(*batch.m_vb, VertexBufferLayout::Create<QuadVertex>());
+
+		batch.m_capacity = capacity;
+		batch.m_dirtyFirst = 0;
+		batch.m_dirtyLast = count;
+	}
+
+	// only the dirty range of sprites is written
+
+	uint32_t first = batch.m_dirtyFirst;
+	uint32_t last = std::min(batch.m_dirtyLast, count);
+
+	if (first < last)
+	{
+		rd.staticVertices.resize(4 * (last - first));
+
+		for (uint32_t i = first; i < last; i++)
+		{
+			const QuadCommand& sprite = batch.m_sprites[i];
+
+			WriteQuadVertices(&rd.staticVertices[4 * (i - first)], sprite.position, sprite.size, sprite.rotation, sprite.textureRect, sprite.color, (uint32_t)batch.m_slots[i]);
+		}
+
+		batch.m_vb->Bind();
+		batch.m_vb->SetData(4 * first * sizeof(QuadVertex), rd.staticVertices.size() * sizeof(QuadVertex), rd.staticVertices.data());
+
+		rd.stats.bytesUploaded += rd.staticVertices.size() * sizeof(QuadVertex);
+	}
+
+	batch.m_dirtyFirst = 0;
+	batch.m_dirtyLast = 0;
+}
+
+void Renderer::DrawStaticBatch(StaticBatch& batch)
+{
+	if (batch.GetCount() == 0)
+		return;
+
+	// keep the order with the draws submitted before
+
+	FlushAll(FlushReason::STATE_CHANGE);
+
+	UploadStaticBatch(batch);
+
+	rd.gpuProfiler.Begin("Static batch");
+
+	// the batch always uses the vertex format of the batched quads with texture slots
+
+	rd.staticBatchShader->Bind();
+	UpdateCameraUniforms();
+	rd.staticBatchShader->SetUniform1iv(rd.staticBatchSamplers, rd.textureSlots, rd.samplers);
+
+	batch.m_va->Bind();
+	batch.m_ib->Bind();
+
+	// one draw per segment that intersects the view
+
+	for (const auto& segment : batch.GetSegments())
+	{
+		if (rd.specification.culling && !segment.bounds.Overlaps(rd.camera.GetVisibleRect()))
+			continue;
+
+		for (int i = 0; i < (int)segment.textures.size(); i++)
+		{
+			if (segment.textures[i]->HasPendingMips())
+				segment.textures[i]->UpdateMips();
+
+			RenderState::BindTextureUnit(i, GL_TEXTURE_2D, segment.textures[i]->GetId());
+		}
+
+		glDrawElements(GL_TRIANGLES, 6 * segment.count, GL_UNSIGNED_INT, (const void*)(6 * segment.first * sizeof(unsigned int)));
+
+		rd.stats.drawCalls++;
+		rd.stats.quads += segment.count;
+		rd.stats.vertices += 4 * segment.count;
+		rd.stats.textureBinds += (int)segment.textures.size();
+	}
+
+	rd.gpuProfiler.End();
+}
+
+void Renderer::Submit(const CommandList& commandList)
+{
+	int layer = rd.layer;
+	BlendMode blendMode = rd.blendMode;
+
+	const auto& quads = commandList.GetQuads();
+	const auto& lines = commandList.GetLines();
+
+	// replay the runs with the state they were recorded with
+
+	for (const auto& run : commandList.GetRuns())
+	{
+		SetLayer(run.layer);
+
+		if (run.blendMode != rd.blendMode)
+			SetBlendMode(run.blendMode);
+
+		if (run.pipeline == CommandPipeline::QUADS)
+			SubmitQuads(&quads[run.first], run.count);
+		else
+		{
+			for (uint32_t i = run.first; i < run.first + run.count; i++)
+			{
+				const LineCommand& line = lines[i];
+
+				// the sides of a rect start half a width before their corner so thick outlines have filled
+				// corners, the same outline as Renderer::DrawRect
+
+				glm::vec2 start = line.p1;
+
+				if (line.rectSide && IsTriangleLines() && line.p2 != line.p1)
+				{
+					glm::vec2 direction = line.p2 - line.p1;
+					start -= direction * (line.width * 0.5f / glm::length(direction));
+				}
+
+				SubmitLine(start, line.p2, line.width, line.color);
+			}
+		}
+	}
+
+	// restore the state of the renderer
+
+	rd.layer = layer;
+
+	if (rd.blendMode != blendMode)
+		SetBlendMode(blendMode);
+}
+
+void Renderer::DrawLine(const glm::vec2& p1, const glm::vec2& p2, const glm::vec4& color)
+{
+	SubmitLine(p1, p2, rd.lineWidth, color);
+}
+
+void Renderer::DrawLine(const glm::vec2& p1, const glm::vec2& p2, float width, const glm::vec4& color)
+{
+	SubmitLine(p1, p2, width, color);
 }
 
 void Renderer::DrawRect(const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
 {
-	DrawLine(position, glm::vec2(position.x + size.x, position.y), color);
-	DrawLine(glm::vec2(position.x + size.x, position.y), glm::vec2(position.x + size.x, position.y + size.y), color);
-	DrawLine(glm::vec2(position.x + size.x, position.y + size.y), glm::vec2(position.x, position.y + size.y), color);
-	DrawLine(glm::vec2(position.x, position.y + size.y), position, color);
+	DrawRect(position, size, rd.lineWidth, color);
+}
+
+void Renderer::DrawRect(const glm::vec2& position, const glm::vec2& size, float width, const glm::vec4& color)
+{
+	if (IsTriangleLines())
+	{
+		glm::vec2 corners[4] = { position, { position.x + size.x, position.y }, position + size, { position.x, position.y + size.y } };
+
+		DrawPolyline(corners, 4, width, color, true);
+	}
+	else
+	{
+		SubmitLine(position, glm::vec2(position.x + size.x, position.y), width, color);
+		SubmitLine(glm::vec2(position.x + size.x, position.y), glm::vec2(position.x + size.x, position.y + size.y), width, color);
+		SubmitLine(glm::vec2(position.x + size.x, position.y + size.y), glm::vec2(position.x, position.y + size.y), width, color);
+		SubmitLine(glm::vec2(position.x, position.y + size.y), position, width, color);
+	}
+}
+
+static void PushPolyline(const glm::vec2* points, size_t count, float width, const glm::vec4& color, bool closed)
+{
+	const float MITER_LIMIT = 4.0f; // longest mitre in half widths, sharper joins are beveled
+
+	// repeated points have no direction
+
+	auto& p = rd.polylinePoints;
+	p.clear();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (p.empty() || points[i] != p.back())
+			p.push_back(points[i]);
+	}
+
+	if (closed && p.size() > 2 && p.front() == p.back())
+		p.pop_back();
+
+	size_t n = p.size();
+
+	if (n < 2)
+		return;
+
+	if (n == 2)
+		closed = false;
+
+	float halfWidth = width * 0.5f;
+
+	// cull the whole polyline with its bounds
+
+	if (rd.specification.culling)
+	{
+		Rect bounds = { p[0], p[0] };
+
+		for (const auto& point : p)
+			bounds = { glm::min(bounds.min, point), glm::max(bounds.max, point) };
+
+		float margin = MITER_LIMIT * halfWidth;
+
+		if (!Rect{ bounds.min - margin, bounds.max + margin }.Overlaps(rd.camera.GetVisibleRect()))
+			return;
+	}
+
+	auto normal = [&](size_t segment)
+	{
+		glm::vec2 direction = glm::normalize(p[(segment + 1) % n] - p[segment]);
+		return glm::vec2(-direction.y, direction.x);
+	};
+
+	// offsets of the joins
+
+	auto& offsets = rd.polylineOffsets;
+	offsets.resize(2 * n);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		bool join = closed || (i > 0 && i < n - 1);
+
+		if (!join)
+		{
+			glm::vec2 offset = normal(i == 0 ? 0 : n - 2) * halfWidth;
+
+			offsets[2 * i] = offset;
+			offsets[2 * i + 1] = offset;
+			continue;
+		}
+
+		glm::vec2 n0 = normal((i + n - 1) % n);
+		glm::vec2 n1 = normal(i);
+		glm::vec2 miter = n0 + n1;
+
+		float miterLength = glm::length(miter);
+		float projection = miterLength > 1e-6f ? glm::dot(miter / miterLength, n0) : 0.0f;
+
+		if (projection * MITER_LIMIT > 1.0f)
+		{
+			// mitre, both segments meet on the bisector
+
+			glm::vec2 offset = (miter / miterLength) * (halfWidth / projection);
+
+			offsets[2 * i] = offset;
+			offsets[2 * i + 1] = offset;
+		}
+		else
+		{
+			// bevel, the segments keep their own offsets and a triangle fills the outer side
+
+			offsets[2 * i] = n0 * halfWidth;
+			offsets[2 * i + 1] = n1 * halfWidth;
+
+			glm::vec2 d0 = p[i] - p[(i + n - 1) % n];
+			glm::vec2 d1 = p[(i + 1) % n] - p[i];
+			float side = d0.x * d1.y - d0.y * d1.x > 0.0f ? -1.0f : 1.0f;
+
+			glm::vec2 corners[4] = { p[i], p[i] + side * offsets[2 * i], p[i] + side * offsets[2 * i + 1], p[i] + side * offsets[2 * i + 1] };
+
+			PushQuadCorners(rd.whiteTexture.get(), corners, color);
+		}
+	}
+
+	// one quad per segment between the offsets of its ends
+
+	size_t segmentsCount = closed ? n : n - 1;
+
+	for (size_t i = 0; i < segmentsCount; i++)
+	{
+		size_t j = (i + 1) % n;
+
+		const glm::vec2& startOffset = offsets[2 * i + 1];
+		const glm::vec2& endOffset = offsets[2 * j];
+
+		glm::vec2 corners[4] = { p[i] - startOffset, p[j] - endOffset, p[j] + endOffset, p[i] + startOffset };
+
+		PushQuadCorners(rd.whiteTexture.get(), corners, color);
+	}
+}
+
+void Renderer::DrawPolyline(const glm::vec2* points, size_t count, float width, const glm::vec4& color, bool closed)
+{
+	if (count < 2)
+		return;
+
+	if (IsTriangleLines() && !rd.specification.deferred && !UsesQuadRecords())
+	{
+		rd.stats.lines += (int)(closed ? count : count - 1);
+
+		PushPolyline(points, count, width, color, closed);
+		return;
+	}
+
+	// segments one by one, in triangle mode the ends that join another segment are extended by half
+	// the width so the joins are filled (square joins)
+
+	float extension = IsTriangleLines() ? width * 0.5f : 0.0f;
+	size_t segmentsCount = closed ? count : count - 1;
+
+	for (size_t i = 0; i < segmentsCount; i++)
+	{
+		glm::vec2 p1 = points[i];
+		glm::vec2 p2 = points[(i + 1) % count];
+
+		glm::vec2 direction = p2 - p1;
+		float length = glm::length(direction);
+
+		if (length > 0.0f && extension > 0.0f)
+		{
+			direction *= extension / length;
+
+			if (closed || i > 0)
+				p1 -= direction;
+
+			if (closed || i < segmentsCount - 1)
+				p2 += direction;
+		}
+
+		SubmitLine(p1, p2, width, color);
+	}
 }
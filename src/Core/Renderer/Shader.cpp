@@ -1,9 +1,14 @@
 #include "Core/Renderer/Shader.h"
 #include <GL/glew.h>
+#include "Core/Renderer/RenderState.h"
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <string>
+#include <algorithm>
+#include <filesystem>
+#include <cstdio>
 
 /* auxiliar struct for storing the vertex and fragment shader code */
 
@@ -15,43 +20,109 @@ struct ShaderCode
 
 /* parse the shader */
 
-static ShaderCode ParseShader(const std::string& path)
+enum class ShaderType
 {
-	enum class ShaderType
-	{
-		VERTEX,
-		FRAGMENT
-	};
+	VERTEX,
+	FRAGMENT
+};
 
-	std::ifstream file(path);
+struct ShaderParser
+{
 	std::stringstream ss[2];
+	std::vector<std::filesystem::path> included[2]; // every file is pasted once per stage
+	const ShaderDefines* defines;
+	ShaderType type = ShaderType::VERTEX;
+};
 
-	if (file.is_open())
+static bool PreprocessShader(ShaderParser& parser, const std::filesystem::path& path, bool root)
+{
+	std::ifstream file(path);
+
+	if (!file.is_open())
 	{
-		std::string line;
-		ShaderType type = ShaderType::VERTEX;
+		std::cout << "[ERROR] Shader file not found \"" << path.string() << "\"" << std::endl;
+		return false;
+	}
+
+	std::string line;
+
+	while (std::getline(file, line))
+	{
+		size_t first = line.find_first_not_of(" \t");
+
+		if (first == std::string::npos || line[first] != '#')
+		{
+			parser.ss[(int)parser.type] << line << "\n";
+			continue;
+		}
 
-		while (std::getline(file, line))
+		if (root && line.compare(first, 5, "#type") == 0)
+		{
+			if (line.find("vertex") != std::string::npos)
+				parser.type = ShaderType::VERTEX;
+			else if (line.find("fragment") != std::string::npos)
+				parser.type = ShaderType::FRAGMENT;
+		}
+		else if (line.compare(first, 8, "#include") == 0)
 		{
-			if (line.find("#type") != std::string::npos)
+			// #include "file", relative to the including file
+
+			size_t begin = line.find('"', first);
+			size_t end = begin != std::string::npos ? line.find('"', begin + 1) : std::string::npos;
+
+			if (end == std::string::npos)
+			{
+				std::cout << "[ERROR] Shader include without a \"file\" in \"" << path.string() << "\"" << std::endl;
+				return false;
+			}
+
+			std::filesystem::path includePath = (path.parent_path() / line.substr(begin + 1, end - begin - 1)).lexically_normal();
+			std::vector<std::filesystem::path>& included = parser.included[(int)parser.type];
+
+			// also stops include cycles
+
+			if (std::find(included.begin(), included.end(), includePath) != included.end())
+				continue;
+
+			included.push_back(includePath);
+
+			if (!PreprocessShader(parser, includePath, false))
+				return false;
+		}
+		else
+		{
+			parser.ss[(int)parser.type] << line << "\n";
+
+			// the permutation defines go right after the version, before anything that can test them
+
+			if (root && line.compare(first, 8, "#version") == 0)
 			{
-				if (line.find("vertex") != std::string::npos)
-					type = ShaderType::VERTEX;
-				else if (line.find("fragment") != std::string::npos)
-					type = ShaderType::FRAGMENT;
+				for (const std::string& define : *parser.defines)
+					parser.ss[(int)parser.type] << "#define " << define << "\n";
 			}
-			else
-				ss[(int)type] << line << "\n";
 		}
 	}
 
-	return { ss[0].str(), ss[1].str() };
+	return true;
+}
+
+static ShaderCode ParseShader(const std::string& path, const ShaderDefines& defines)
+{
+	ShaderParser parser;
+	parser.defines = &defines;
+
+	if (!PreprocessShader(parser, path, true))
+		return {};
+
+	return { parser.ss[0].str(), parser.ss[1].str() };
 }
 
 /* compile shader */
 
 static unsigned int CompileShader(const std::string& code, int type)
 {
+	// the status is checked when the program is finished, the driver may still be compiling
+
 	unsigned int shaderId = glCreateShader(type);
 
 	const char* cstrCode = code.c_str();
@@ -59,6 +130,11 @@ static unsigned int CompileShader(const std::string& code, int type)
 	glShaderSource(shaderId, 1, &cstrCode, nullptr);
 	glCompileShader(shaderId);
 
+	return shaderId;
+}
+
+static bool CheckShader(unsigned int shaderId)
+{
 	int compileStatus;
 	glGetShaderiv(shaderId, GL_COMPILE_STATUS, &compileStatus);
 
@@ -73,12 +149,182 @@ static unsigned int CompileShader(const std::string& code, int type)
 
 		delete[] message;
 
-		glDeleteShader(shaderId);
+		return false;
+	}
+
+	return true;
+}
+
+/* parallel compile */
+
+static bool IsParallelCompileSupported()
+{
+	static bool supported = false;
+	static bool initialized = false;
+
+	if (!initialized)
+	{
+		initialized = true;
+
+		// let the driver use as many compiler threads as it wants
+
+		if (GLEW_KHR_parallel_shader_compile)
+		{
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+			supported = true;
+		}
+		else if (GLEW_ARB_parallel_shader_compile)
+		{
+			glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+			supported = true;
+		}
+	}
+
+	return supported;
+}
+
+struct ShaderCompile
+{
+	unsigned int vertexShaderId;
+	unsigned int fragmentShaderId;
+	std::string binaryPath; // where to save the linked binary, empty when the cache is disabled
+};
+
+/* PROGRAM BINARY CACHE */
+
+struct ProgramBinaryHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format; // driver specific, returned by glGetProgramBinary
+	uint32_t size;
+};
+
+static const uint32_t PROGRAM_BINARY_MAGIC = 0x50424742; // "BGBP"
+static const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+static std::string s_binaryCacheDirectory;
+static ShaderCacheStats s_cacheStats;
+
+static uint64_t HashBytes(uint64_t hash, const char* data, size_t size)
+{
+	// fnv-1a 64
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static std::string GetBinaryCachePath(const ShaderCode& code)
+{
+	// the binaries are only valid for the same sources and the same driver
+
+	uint64_t hash = 14695981039346656037ull;
+
+	const char* strings[] = {
+		code.vertexShaderCode.c_str(), code.fragmentShaderCode.c_str(),
+		(const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION)
+	};
+
+	for (const char* string : strings)
+	{
+		if (string != nullptr)
+			hash = HashBytes(hash, string, std::strlen(string) + 1); // with the terminator so "ab" + "c" != "a" + "bc"
+	}
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+
+	return s_binaryCacheDirectory + "/" + name;
+}
+
+static bool IsBinaryCacheEnabled()
+{
+	return !s_binaryCacheDirectory.empty() && GLEW_ARB_get_program_binary;
+}
+
+static unsigned int LoadProgramBinary(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+		return 0;
+
+	ProgramBinaryHeader header;
+
+	if (!file.read((char*)&header, sizeof(header)) || header.magic != PROGRAM_BINARY_MAGIC || header.version != PROGRAM_BINARY_VERSION)
+		return 0;
+
+	// the size comes from the file, checked against what is left of it before allocating
 
+	std::streamoff begin = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::streamoff remaining = file.tellg() - begin;
+	file.seekg(begin);
+
+	if (header.format == 0 || header.size == 0 || (std::streamoff)header.size > remaining)
+	{
+		s_cacheStats.rejected++;
 		return 0;
 	}
 
-	return shaderId;
+	std::vector<char> binary(header.size);
+
+	if (!file.read(binary.data(), header.size))
+		return 0;
+
+	unsigned int programId = glCreateProgram();
+
+	glProgramBinary(programId, header.format, binary.data(), header.size);
+
+	// the driver refuses binaries of other versions even with the same version string
+
+	int linkStatus;
+	glGetProgramiv(programId, GL_LINK_STATUS, &linkStatus);
+
+	if (linkStatus == GL_FALSE)
+	{
+		glDeleteProgram(programId);
+		s_cacheStats.rejected++;
+
+		return 0;
+	}
+
+	return programId;
+}
+
+static void SaveProgramBinary(unsigned int programId, const std::string& path)
+{
+	int length = 0;
+	glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length == 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format;
+
+	glGetProgramBinary(programId, length, &length, &format, binary.data());
+
+	std::error_code error;
+	std::filesystem::create_directories(s_binaryCacheDirectory, error);
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+	{
+		std::cout << "[WARNING] Can't write the program binary \"" << path << "\"" << std::endl;
+		return;
+	}
+
+	ProgramBinaryHeader header = { PROGRAM_BINARY_MAGIC, PROGRAM_BINARY_VERSION, format, (uint32_t)length };
+
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), length);
 }
 
 /* SHADER CLASS */
@@ -92,170 +338,402 @@ Shader::Shader(Shader&& other) noexcept
 {
 	m_id = other.m_id;
 	m_path = std::move(other.m_path);
-	m_uniformCache = std::move(other.m_uniformCache);
+	m_defines = std::move(other.m_defines);
+	m_uniforms = std::move(other.m_uniforms);
+	m_uniformBlocks = std::move(other.m_uniformBlocks);
+	m_missingUniforms = std::move(other.m_missingUniforms);
+	m_compile = std::move(other.m_compile);
 
 	other.m_id = 0;
 }
 
-Shader::Shader(const std::string& path)
+Shader::Shader(const std::string& path, const ShaderDefines& defines) : Shader()
 {
-	Load(path);
+	Load(path, defines);
 }
 
 Shader::~Shader()
 {
-	glDeleteProgram(m_id);
-	 
+	Release();
+
 	std::cout << "[INFO] Shader destroyed \"" << m_path << "\"" << std::endl;
 }
 
-void Shader::Load(const std::string& path)
+void Shader::Load(const std::string& path, const ShaderDefines& defines)
 {
-	// parse
+	LoadAsync(path, defines);
+	Wait();
+}
 
-	auto[vertexShaderCode, fragmentShaderCode] = ParseShader(path);
+void Shader::LoadAsync(const std::string& path, const ShaderDefines& defines)
+{
+	// parse, the defines end up in the code so the binary cache keeps one program per permutation
+
+	ShaderCode code = ParseShader(path, defines);
 
 	// check if the parse is correct
 
-	if (vertexShaderCode.size() == 0 || fragmentShaderCode.size() == 0)
+	if (code.vertexShaderCode.size() == 0 || code.fragmentShaderCode.size() == 0)
 	{
 		std::cout << "[ERROR] Shader loading \"" << path << "\"" << std::endl;
 		return;
 	}
 
-	// compile the vertex and fragment shader
+	// drop the program (or the compile still pending) of a previous load
+
+	Release();
+
+	m_uniforms.clear();
+	m_uniformBlocks.clear();
+	m_missingUniforms.clear();
 
-	unsigned int vertexShaderId = CompileShader(vertexShaderCode, GL_VERTEX_SHADER);
-	unsigned int fragmentShaderId = CompileShader(fragmentShaderCode, GL_FRAGMENT_SHADER);
+	// try the binary linked on a previous run
 
-	// check if the compilation is correct
+	std::string binaryPath;
 
-	if (vertexShaderId == 0 || fragmentShaderId == 0)
+	if (IsBinaryCacheEnabled())
 	{
-		std::cout << "[ERROR] Shader compilation \"" << path << "\"" << std::endl;
-		return;
+		binaryPath = GetBinaryCachePath(code);
+
+		unsigned int programId = LoadProgramBinary(binaryPath);
+
+		if (programId != 0)
+		{
+			s_cacheStats.hits++;
+
+			m_id = programId;
+			m_path = path;
+			m_defines = defines;
+
+			Reflect();
+
+			std::cout << "[INFO] Shader loaded from the binary cache \"" << path << "\"" << std::endl;
+			return;
+		}
+
+		s_cacheStats.misses++;
 	}
 
-	// if all correct then create the shader program and attach the shaders
+	IsParallelCompileSupported();
+
+	// submit the compilation of both shaders and the link without waiting for any of them
+
+	unsigned int vertexShaderId = CompileShader(code.vertexShaderCode, GL_VERTEX_SHADER);
+	unsigned int fragmentShaderId = CompileShader(code.fragmentShaderCode, GL_FRAGMENT_SHADER);
 
 	m_id = glCreateProgram();
 	m_path = path;
+	m_defines = defines;
+
+	if (!binaryPath.empty())
+		glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 
 	glAttachShader(m_id, vertexShaderId);
 	glAttachShader(m_id, fragmentShaderId);
 	glLinkProgram(m_id);
-	glValidateProgram(m_id);
 
-	glDeleteShader(vertexShaderId);
-	glDeleteShader(fragmentShaderId);
+	m_compile = std::make_unique<ShaderCompile>(ShaderCompile{ vertexShaderId, fragmentShaderId, binaryPath });
+}
+
+void Shader::Release()
+{
+	if (m_compile)
+	{
+		glDeleteShader(m_compile->vertexShaderId);
+		glDeleteShader(m_compile->fragmentShaderId);
+		m_compile.reset();
+	}
+
+	if (m_id != 0)
+	{
+		RenderState::ForgetProgram(m_id);
+		glDeleteProgram(m_id);
+		m_id = 0;
+	}
+}
+
+bool Shader::IsReady() const
+{
+	if (!m_compile)
+		return true;
+
+	// without the extension there is no way to ask, Wait blocks as long as it has to
+
+	if (!IsParallelCompileSupported())
+		return true;
+
+	int completed;
+	glGetProgramiv(m_id, GL_COMPLETION_STATUS_KHR, &completed);
+
+	return completed == GL_TRUE;
+}
+
+void Shader::Wait() const
+{
+	if (!m_compile)
+		return;
+
+	std::unique_ptr<ShaderCompile> compile = std::move(m_compile);
+
+	// check the shaders and the link, the status queries block until the driver is done
+
+	bool compiled = CheckShader(compile->vertexShaderId) & CheckShader(compile->fragmentShaderId);
+
+	glDeleteShader(compile->vertexShaderId);
+	glDeleteShader(compile->fragmentShaderId);
+
+	if (!compiled)
+	{
+		std::cout << "[ERROR] Shader compilation \"" << m_path << "\"" << std::endl;
+
+		glDeleteProgram(m_id);
+		m_id = 0;
+		return;
+	}
+
+	int linkStatus;
+	glGetProgramiv(m_id, GL_LINK_STATUS, &linkStatus);
+
+	if (linkStatus == GL_FALSE)
+	{
+		int length;
+		glGetProgramiv(m_id, GL_INFO_LOG_LENGTH, &length);
+		std::string message(length, '\0');
+		glGetProgramInfoLog(m_id, length, &length, message.data());
+
+		std::cout << message << std::endl;
+		std::cout << "[ERROR] Shader linking \"" << m_path << "\"" << std::endl;
+
+		glDeleteProgram(m_id);
+		m_id = 0;
+		return;
+	}
+
+	if (!compile->binaryPath.empty())
+		SaveProgramBinary(m_id, compile->binaryPath);
+
+	// uniform table
+
+	Reflect();
 
 	// shader corretly
 
-	std::cout << "[INFO] Shader loaded \"" << path << "\"" << std::endl;
+	std::cout << "[INFO] Shader loaded \"" << m_path << "\"" << std::endl;
+}
+
+void Shader::SetBinaryCacheDirectory(const std::string& directory)
+{
+	s_binaryCacheDirectory = directory;
+}
+
+const ShaderCacheStats& Shader::GetCacheStats()
+{
+	return s_cacheStats;
+}
+
+void Shader::Reflect() const
+{
+	m_uniforms.clear();
+	m_uniformBlocks.clear();
+	m_missingUniforms.clear();
+
+	// uniforms outside the blocks
+
+	int count = 0;
+	glGetProgramInterfaceiv(m_id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+	const GLenum uniformProperties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+
+	for (int i = 0; i < count; i++)
+	{
+		GLint values[5];
+		glGetProgramResourceiv(m_id, GL_UNIFORM, i, 5, uniformProperties, 5, nullptr, values);
+
+		if (values[4] != -1)
+			continue;
+
+		std::string name(values[0], '\0');
+		glGetProgramResourceName(m_id, GL_UNIFORM, i, values[0], nullptr, name.data());
+		name.resize(values[0] - 1);
+
+		// arrays are reported as "name[0]"
+
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			name.resize(name.size() - 3);
+
+		m_uniforms.push_back({ HashUniformName(name), name, values[2], (unsigned int)values[1], values[3], {} });
+	}
+
+	std::sort(m_uniforms.begin(), m_uniforms.end(), [](const ShaderUniform& a, const ShaderUniform& b) { return a.hash < b.hash; });
+
+	// uniform blocks
+
+	glGetProgramInterfaceiv(m_id, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &count);
+
+	const GLenum blockProperties[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+
+	for (int i = 0; i < count; i++)
+	{
+		GLint values[3];
+		glGetProgramResourceiv(m_id, GL_UNIFORM_BLOCK, i, 3, blockProperties, 3, nullptr, values);
+
+		std::string name(values[0], '\0');
+		glGetProgramResourceName(m_id, GL_UNIFORM_BLOCK, i, values[0], nullptr, name.data());
+		name.resize(values[0] - 1);
+
+		m_uniformBlocks.push_back({ name, values[1], values[2] });
+	}
 }
 
-int Shader::GetUniformLocation(const std::string& name)
+int Shader::FindUniform(UniformName name) const
 {
-	// check if the uniform is already in the "cache"
+	auto it = std::lower_bound(m_uniforms.begin(), m_uniforms.end(), name.hash, [](const ShaderUniform& uniform, uint32_t hash) { return uniform.hash < hash; });
+
+	// the name is compared too in case of a collision
+
+	for (; it != m_uniforms.end() && it->hash == name.hash; ++it)
+	{
+		if (it->name == name.name)
+			return (int)(it - m_uniforms.begin());
+	}
+
+	return -1;
+}
+
+UniformHandle Shader::GetUniformHandle(UniformName name)
+{
+	Wait();
+
+	int index = FindUniform(name);
+
+	// not declared or removed by the compiler, warn only the first time
+
+	if (index == -1 && std::find(m_missingUniforms.begin(), m_missingUniforms.end(), name.hash) == m_missingUniforms.end())
+	{
+		std::cout << "[WARNING] Uniform \"" << name.name << "\" is not active in \"" << m_path << "\"" << std::endl;
+		m_missingUniforms.push_back(name.hash);
+	}
 
-	auto it = m_uniformCache.find(name);
+	return { index };
+}
 
-	if (it != m_uniformCache.end())
-		return it->second;
+bool Shader::HasUniform(UniformName name) const
+{
+	return FindUniform(name) != -1;
+}
 
-	// if not get the location
+bool Shader::HasUniformBlock(std::string_view name) const
+{
+	for (const auto& block : m_uniformBlocks)
+	{
+		if (block.name == name)
+			return true;
+	}
 
-	int location = glGetUniformLocation(m_id, name.c_str());
+	return false;
+}
 
-	// check if doesnt exist to output a warning
+int Shader::GetLocationIfChanged(UniformHandle handle, const void* data, size_t size)
+{
+	if (!handle.IsValid())
+		return -1;
+
+	ShaderUniform& uniform = m_uniforms[handle.index];
 
-	if (location == -1)
-		std::cout << "[WARNING] Uniform \"" << name << "\" does not exist" << std::endl;
+	// the program keeps the last value uploaded, skip the upload if it is the same
 
-	// even if it does not exist store the uniform into the hashmap
+	if (uniform.value.size() == size && std::memcmp(uniform.value.data(), data, size) == 0)
+	{
+		RenderState::CountElidedUniform();
+		return -1;
+	}
 
-	m_uniformCache[name] = location;
+	uniform.value.assign((const unsigned char*)data, (const unsigned char*)data + size);
 
-	return location;
+	return uniform.location;
 }
 
 void Shader::Bind() const
 {
-	glUseProgram(m_id);
+	// binding a shader still compiling finishes it (the uniform table is filled then)
+
+	Wait();
+
+	RenderState::UseProgram(m_id);
 }
 
 void Shader::UnBind() const
 {
-	glUseProgram(0);
+	RenderState::UseProgram(0);
 }
 
-void Shader::SetUniformMat4(const std::string& name, const glm::mat4& mat)
+void Shader::SetUniformMat4(UniformHandle handle, const glm::mat4& mat)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, &mat, sizeof(glm::mat4));
 
 	if (uniformId != -1)
 		glUniformMatrix4fv(uniformId, 1, false, &mat[0][0]);
 }
 
-void Shader::SetUniform1iv(const std::string& name, int count, const int* data)
+void Shader::SetUniform1iv(UniformHandle handle, int count, const int* data)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, data, count * sizeof(int));
 
 	if (uniformId != -1)
 		glUniform1iv(uniformId, count, data);
 }
 
-void Shader::SetUniform1i(const std::string& name, int data)
+void Shader::SetUniform1i(UniformHandle handle, int data)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, &data, sizeof(int));
 
 	if (uniformId != -1)
 		glUniform1i(uniformId, data);
 }
 
-void Shader::SetUniform1f(const std::string& name, float data)
+void Shader::SetUniform1f(UniformHandle handle, float data)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, &data, sizeof(float));
 
 	if (uniformId != -1)
 		glUniform1f(uniformId, data);
 }
 
-void Shader::SetUniformVec2(const std::string& name, const glm::vec2& data)
+void Shader::SetUniformVec2(UniformHandle handle, const glm::vec2& data)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, &data, sizeof(glm::vec2));
 
 	if (uniformId != -1)
 		glUniform2f(uniformId, data.x, data.y);
 }
 
-void Shader::SetUniformVec3(const std::string& name, const glm::vec3& data)
+void Shader::SetUniformVec3(UniformHandle handle, const glm::vec3& data)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, &data, sizeof(glm::vec3));
 
 	if (uniformId != -1)
 		glUniform3f(uniformId, data.x, data.y, data.z);
 }
 
-void Shader::SetUniformVec4(const std::string& name, const glm::vec4& data)
+void Shader::SetUniformVec4(UniformHandle handle, const glm::vec4& data)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, &data, sizeof(glm::vec4));
 
 	if (uniformId != -1)
 		glUniform4f(uniformId, data.x, data.y, data.z, data.w);
 }
 
-void Shader::SetUniformVec2v(const std::string& name, int count, const glm::vec2* data)
+void Shader::SetUniformVec2v(UniformHandle handle, int count, const glm::vec2* data)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, data, count * sizeof(glm::vec2));
 
 	if (uniformId != -1)
 		glUniform2fv(uniformId, count, (const float*)data);
 }
 
-void Shader::SetUniformVec3v(const std::string& name, int count, const glm::vec3* data)
+void Shader::SetUniformVec3v(UniformHandle handle, int count, const glm::vec3* data)
 {
-	int uniformId = GetUniformLocation(name);
+	int uniformId = GetLocationIfChanged(handle, data, count * sizeof(glm::vec3));
 
 	if (uniformId != -1)
 		glUniform3fv(uniformId, count, (const float*)data);
@@ -265,9 +743,15 @@ Shader& Shader::operator=(Shader&& other) noexcept
 {
 	if (this != &other)
 	{
+		Release();
+
 		m_id = other.m_id;
 		m_path = std::move(other.m_path);
-		m_uniformCache = std::move(other.m_uniformCache);
+		m_defines = std::move(other.m_defines);
+		m_uniforms = std::move(other.m_uniforms);
+		m_uniformBlocks = std::move(other.m_uniformBlocks);
+		m_missingUniforms = std::move(other.m_missingUniforms);
+		m_compile = std::move(other.m_compile);
 
 		other.m_id = 0;
 	}
@@ -0,0 +1,48 @@
+#include "Core/Renderer/ShaderLibrary.h"
+#include <unordered_map>
+#include <algorithm>
+#include <memory>
+
+static std::unordered_map<std::string, std::unique_ptr<Shader>> s_shaders;
+
+static std::string GetPermutationKey(const std::string& path, ShaderDefines& defines)
+{
+	std::sort(defines.begin(), defines.end());
+	defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+
+	std::string key = path;
+
+	for (const std::string& define : defines)
+	{
+		key += '|';
+		key += define;
+	}
+
+	return key;
+}
+
+Shader* ShaderLibrary::Get(const std::string& path, const ShaderDefines& defines)
+{
+	ShaderDefines sortedDefines = defines;
+	std::string key = GetPermutationKey(path, sortedDefines);
+
+	std::unique_ptr<Shader>& shader = s_shaders[key];
+
+	if (!shader)
+	{
+		shader = std::make_unique<Shader>();
+		shader->LoadAsync(path, sortedDefines);
+	}
+
+	return shader.get();
+}
+
+int ShaderLibrary::GetCount()
+{
+	return (int)s_shaders.size();
+}
+
+void ShaderLibrary::Clear()
+{
+	s_shaders.clear();
+}
@@ -0,0 +1,208 @@
+#include "Core/Renderer/SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+SpatialGrid::SpatialGrid(float cellSize)
+{
+	assert(cellSize > 0.0f);
+
+	m_cellSize = cellSize;
+	m_invCellSize = 1.0f / cellSize;
+	m_count = 0;
+	m_queryStamp = 0;
+}
+
+void SpatialGrid::Clear()
+{
+	m_cells.clear();
+	m_items.clear();
+	m_freeHandles.clear();
+	m_queryStamps.clear();
+	m_count = 0;
+	m_queryStamp = 0;
+}
+
+glm::ivec2 SpatialGrid::GetCell(const glm::vec2& position) const
+{
+	return { (int)std::floor(position.x * m_invCellSize), (int)std::floor(position.y * m_invCellSize) };
+}
+
+void SpatialGrid::AddToCells(uint32_t handle)
+{
+	const Item& item = m_items[handle];
+
+	for (int y = item.minCell.y; y <= item.maxCell.y; y++)
+	{
+		for (int x = item.minCell.x; x <= item.maxCell.x; x++)
+			m_cells[GetCellKey(x, y)].push_back(handle);
+	}
+}
+
+void SpatialGrid::RemoveFromCells(uint32_t handle)
+{
+	const Item& item = m_items[handle];
+
+	for (int y = item.minCell.y; y <= item.maxCell.y; y++)
+	{
+		for (int x = item.minCell.x; x <= item.maxCell.x; x++)
+		{
+			auto cell = m_cells.find(GetCellKey(x, y));
+
+			if (cell == m_cells.end())
+				continue;
+
+			auto& handles = cell->second;
+			auto it = std::find(handles.begin(), handles.end(), handle);
+
+			if (it != handles.end())
+			{
+				*it = handles.back();
+				handles.pop_back();
+			}
+
+			if (handles.empty())
+				m_cells.erase(cell);
+		}
+	}
+}
+
+uint32_t SpatialGrid::Insert(const SpriteInstance& sprite)
+{
+	uint32_t handle;
+
+	if (!m_freeHandles.empty())
+	{
+		handle = m_freeHandles.back();
+		m_freeHandles.pop_back();
+	}
+	else
+	{
+		handle = (uint32_t)m_items.size();
+		m_items.emplace_back();
+		m_queryStamps.push_back(0);
+	}
+
+	Item& item = m_items[handle];
+	item.sprite = sprite;
+	item.bounds = Rect::FromQuad(sprite.position, sprite.size, sprite.rotation);
+	item.minCell = GetCell(item.bounds.min);
+	item.maxCell = GetCell(item.bounds.max);
+	item.alive = true;
+
+	AddToCells(handle);
+
+	m_count++;
+
+	return handle;
+}
+
+void SpatialGrid::Update(uint32_t handle, const SpriteInstance& sprite)
+{
+	assert(handle < m_items.size() && m_items[handle].alive);
+
+	Item& item = m_items[handle];
+	item.sprite = sprite;
+	item.bounds = Rect::FromQuad(sprite.position, sprite.size, sprite.rotation);
+
+	glm::ivec2 minCell = GetCell(item.bounds.min);
+	glm::ivec2 maxCell = GetCell(item.bounds.max);
+
+	// only touch the cells when the sprite crosses into other ones
+
+	if (minCell != item.minCell || maxCell != item.maxCell)
+	{
+		RemoveFromCells(handle);
+
+		item.minCell = minCell;
+		item.maxCell = maxCell;
+
+		AddToCells(handle);
+	}
+}
+
+void SpatialGrid::Remove(uint32_t handle)
+{
+	assert(handle < m_items.size() && m_items[handle].alive);
+
+	RemoveFromCells(handle);
+
+	m_items[handle].alive = false;
+	m_freeHandles.push_back(handle);
+	m_count--;
+}
+
+void SpatialGrid::Query(const Rect& rect, std::vector<uint32_t>& handles) const
+{
+	size_t first = handles.size();
+
+	glm::ivec2 minCell = GetCell(rect.min);
+	glm::ivec2 maxCell = GetCell(rect.max);
+
+	// new stamp for this query, clear the old ones when it wraps
+
+	if (++m_queryStamp == 0)
+	{
+		std::fill(m_queryStamps.begin(), m_queryStamps.end(), 0);
+		m_queryStamp = 1;
+	}
+
+	auto visitCell = [&](const std::vector<uint32_t>& cell)
+	{
+		for (uint32_t handle : cell)
+		{
+			if (m_queryStamps[handle] == m_queryStamp)
+				continue;
+
+			m_queryStamps[handle] = m_queryStamp;
+
+			if (m_items[handle].bounds.Overlaps(rect))
+				handles.push_back(handle);
+		}
+	};
+
+	// a rect covering more cells than are occupied (zoomed out camera) walks the occupied cells instead
+
+	int64_t cellsCount = (int64_t)(maxCell.x - minCell.x + 1) * (int64_t)(maxCell.y - minCell.y + 1);
+
+	if (cellsCount > (int64_t)m_cells.size())
+	{
+		for (const auto& [key, cell] : m_cells)
+		{
+			int x = (int)(uint32_t)(key >> 32);
+			int y = (int)(uint32_t)key;
+
+			if (x >= minCell.x && x <= maxCell.x && y >= minCell.y && y <= maxCell.y)
+				visitCell(cell);
+		}
+	}
+	else
+	{
+		for (int y = minCell.y; y <= maxCell.y; y++)
+		{
+			for (int x = minCell.x; x <= maxCell.x; x++)
+			{
+				auto cell = m_cells.find(GetCellKey(x, y));
+
+				if (cell != m_cells.end())
+					visitCell(cell->second);
+			}
+		}
+	}
+
+	// the cells are unordered, sort to keep the draw order stable between frames
+
+	std::sort(handles.begin() + first, handles.end());
+}
+
+void SpatialGrid::Query(const Rect& rect, std::vector<SpriteInstance>& sprites) const
+{
+	m_queryHandles.clear();
+
+	Query(rect, m_queryHandles);
+
+	sprites.reserve(sprites.size() + m_queryHandles.size());
+
+	for (uint32_t handle : m_queryHandles)
+		sprites.push_back(m_items[handle].sprite);
+}
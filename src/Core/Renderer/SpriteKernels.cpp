@@ -0,0 +1,267 @@
+#include "Core/Renderer/SpriteKernels.h"
+#include <cmath>
+
+#if defined(__AVX__)
+#define SPRITE_KERNELS_AVX
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPRITE_KERNELS_SSE
+#endif
+
+#if defined(SPRITE_KERNELS_AVX)
+#include <immintrin.h>
+#elif defined(SPRITE_KERNELS_SSE)
+#include <emmintrin.h>
+#endif
+
+/* scalar */
+
+static void StoreCorner(float* out, size_t sprite, int corner, size_t stride, float x, float y)
+{
+	float* vertex = out + (4 * sprite + corner) * stride;
+
+	vertex[0] = x;
+	vertex[1] = y;
+}
+
+static void AxisAlignedCornersScalar(const float* cx, const float* cy, const float* hw, const float* hh, size_t begin, size_t end, float* out, size_t stride)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		StoreCorner(out, i, 0, stride, cx[i] - hw[i], cy[i] - hh[i]);
+		StoreCorner(out, i, 1, stride, cx[i] + hw[i], cy[i] - hh[i]);
+		StoreCorner(out, i, 2, stride, cx[i] + hw[i], cy[i] + hh[i]);
+		StoreCorner(out, i, 3, stride, cx[i] - hw[i], cy[i] + hh[i]);
+	}
+}
+
+static void RotatedCornersScalar(const float* cx, const float* cy, const float* hw, const float* hh, const float* sin, const float* cos, size_t begin, size_t end, float* out, size_t stride)
+{
+	for (size_t i = begin; i < end; i++)
+	{
+		// half size axes rotated
+
+		float axisXx = hw[i] * cos[i];
+		float axisXy = hw[i] * sin[i];
+		float axisYx = -hh[i] * sin[i];
+		float axisYy = hh[i] * cos[i];
+
+		StoreCorner(out, i, 0, stride, cx[i] - axisXx - axisYx, cy[i] - axisXy - axisYy);
+		StoreCorner(out, i, 1, stride, cx[i] + axisXx - axisYx, cy[i] + axisXy - axisYy);
+		StoreCorner(out, i, 2, stride, cx[i] + axisXx + axisYx, cy[i] + axisXy + axisYy);
+		StoreCorner(out, i, 3, stride, cx[i] - axisXx + axisYx, cy[i] - axisXy + axisYy);
+	}
+}
+
+/* sse */
+
+#if defined(SPRITE_KERNELS_SSE)
+
+// store one corner of 4 consecutive sprites, the x and y registers are interleaved into (x, y) pairs
+
+static inline void StoreCorners4(float* out, size_t sprite, int corner, size_t stride, __m128 x, __m128 y)
+{
+	__m128 lo = _mm_unpacklo_ps(x, y); // x0 y0 x1 y1
+	__m128 hi = _mm_unpackhi_ps(x, y); // x2 y2 x3 y3
+
+	_mm_storel_pi((__m64*)(out + (4 * (sprite + 0) + corner) * stride), lo);
+	_mm_storeh_pi((__m64*)(out + (4 * (sprite + 1) + corner) * stride), lo);
+	_mm_storel_pi((__m64*)(out + (4 * (sprite + 2) + corner) * stride), hi);
+	_mm_storeh_pi((__m64*)(out + (4 * (sprite + 3) + corner) * stride), hi);
+}
+
+static inline void SinCos4(__m128 x, __m128* sinOut, __m128* cosOut)
+{
+	// reduce to [-pi/4, pi/4] around the nearest multiple of pi/2 (cody-waite)
+
+	__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.636619772f))); // 2 / pi
+	__m128 y = _mm_cvtepi32_ps(quadrant);
+
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(1.5703125f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(4.837512969970703125e-4f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(7.54978995489188216e-8f)));
+
+	// minimax polynomials (cephes)
+
+	__m128 z = _mm_mul_ps(x, x);
+
+	__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z), _mm_set1_ps(8.3321608736e-3f));
+	s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+	s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+	__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z), _mm_set1_ps(-1.388731625493765e-3f));
+	c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+	c = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(c, z), z), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(z, _mm_set1_ps(0.5f))));
+
+	// odd quadrants swap sin and cos, the sign comes from the quadrant
+
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+	__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+	__m128 sinValue = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+	__m128 cosValue = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+
+	*sinOut = _mm_xor_ps(sinValue, sinSign);
+	*cosOut = _mm_xor_ps(cosValue, cosSign);
+}
+
+#endif
+
+/* SPRITE KERNELS */
+
+void SpriteKernels::SinCos(const float* radians, size_t count, float* sin, float* cos)
+{
+	size_t i = 0;
+
+#if defined(SPRITE_KERNELS_SSE)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 s, c;
+
+		SinCos4(_mm_loadu_ps(radians + i), &s, &c);
+
+		_mm_storeu_ps(sin + i, s);
+		_mm_storeu_ps(cos + i, c);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		sin[i] = std::sin(radians[i]);
+		cos[i] = std::cos(radians[i]);
+	}
+}
+
+void SpriteKernels::AxisAlignedCorners(const float* cx, const float* cy, const float* hw, const float* hh, size_t count, float* out, size_t stride)
+{
+	size_t i = 0;
+
+#if defined(SPRITE_KERNELS_AVX)
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(cx + i);
+		__m256 y = _mm256_loadu_ps(cy + i);
+		__m256 w = _mm256_loadu_ps(hw + i);
+		__m256 h = _mm256_loadu_ps(hh + i);
+
+		__m256 left = _mm256_sub_ps(x, w);
+		__m256 right = _mm256_add_ps(x, w);
+		__m256 top = _mm256_sub_ps(y, h);
+		__m256 bottom = _mm256_add_ps(y, h);
+
+		// 8 sprites are stored as two groups of 4
+
+		__m128 l[2] = { _mm256_castps256_ps128(left), _mm256_extractf128_ps(left, 1) };
+		__m128 r[2] = { _mm256_castps256_ps128(right), _mm256_extractf128_ps(right, 1) };
+		__m128 t[2] = { _mm256_castps256_ps128(top), _mm256_extractf128_ps(top, 1) };
+		__m128 b[2] = { _mm256_castps256_ps128(bottom), _mm256_extractf128_ps(bottom, 1) };
+
+		for (int g = 0; g < 2; g++)
+		{
+			StoreCorners4(out, i + 4 * g, 0, stride, l[g], t[g]);
+			StoreCorners4(out, i + 4 * g, 1, stride, r[g], t[g]);
+			StoreCorners4(out, i + 4 * g, 2, stride, r[g], b[g]);
+			StoreCorners4(out, i + 4 * g, 3, stride, l[g], b[g]);
+		}
+	}
+#endif
+
+#if defined(SPRITE_KERNELS_SSE)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(cx + i);
+		__m128 y = _mm_loadu_ps(cy + i);
+		__m128 w = _mm_loadu_ps(hw + i);
+		__m128 h = _mm_loadu_ps(hh + i);
+
+		__m128 left = _mm_sub_ps(x, w);
+		__m128 right = _mm_add_ps(x, w);
+		__m128 top = _mm_sub_ps(y, h);
+		__m128 bottom = _mm_add_ps(y, h);
+
+		StoreCorners4(out, i, 0, stride, left, top);
+		StoreCorners4(out, i, 1, stride, right, top);
+		StoreCorners4(out, i, 2, stride, right, bottom);
+		StoreCorners4(out, i, 3, stride, left, bottom);
+	}
+#endif
+
+	AxisAlignedCornersScalar(cx, cy, hw, hh, i, count, out, stride);
+}
+
+void SpriteKernels::RotatedCorners(const float* cx, const float* cy, const float* hw, const float* hh, const float* sin, const float* cos, size_t count, float* out, size_t stride)
+{
+	size_t i = 0;
+
+#if defined(SPRITE_KERNELS_AVX)
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(cx + i);
+		__m256 y = _mm256_loadu_ps(cy + i);
+		__m256 w = _mm256_loadu_ps(hw + i);
+		__m256 h = _mm256_loadu_ps(hh + i);
+		__m256 s = _mm256_loadu_ps(sin + i);
+		__m256 c = _mm256_loadu_ps(cos + i);
+
+		__m256 axisXx = _mm256_mul_ps(w, c);
+		__m256 axisXy = _mm256_mul_ps(w, s);
+		__m256 axisYx = _mm256_mul_ps(h, s); // negated below
+		__m256 axisYy = _mm256_mul_ps(h, c);
+
+		__m256 x0 = _mm256_add_ps(_mm256_sub_ps(x, axisXx), axisYx);
+		__m256 y0 = _mm256_sub_ps(_mm256_sub_ps(y, axisXy), axisYy);
+		__m256 x1 = _mm256_add_ps(_mm256_add_ps(x, axisXx), axisYx);
+		__m256 y1 = _mm256_sub_ps(_mm256_add_ps(y, axisXy), axisYy);
+		__m256 x2 = _mm256_sub_ps(_mm256_add_ps(x, axisXx), axisYx);
+		__m256 y2 = _mm256_add_ps(_mm256_add_ps(y, axisXy), axisYy);
+		__m256 x3 = _mm256_sub_ps(_mm256_sub_ps(x, axisXx), axisYx);
+		__m256 y3 = _mm256_add_ps(_mm256_sub_ps(y, axisXy), axisYy);
+
+		__m256 xs[4] = { x0, x1, x2, x3 };
+		__m256 ys[4] = { y0, y1, y2, y3 };
+
+		for (int k = 0; k < 4; k++)
+		{
+			StoreCorners4(out, i, k, stride, _mm256_castps256_ps128(xs[k]), _mm256_castps256_ps128(ys[k]));
+			StoreCorners4(out, i + 4, k, stride, _mm256_extractf128_ps(xs[k], 1), _mm256_extractf128_ps(ys[k], 1));
+		}
+	}
+#endif
+
+#if defined(SPRITE_KERNELS_SSE)
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(cx + i);
+		__m128 y = _mm_loadu_ps(cy + i);
+		__m128 w = _mm_loadu_ps(hw + i);
+		__m128 h = _mm_loadu_ps(hh + i);
+		__m128 s = _mm_loadu_ps(sin + i);
+		__m128 c = _mm_loadu_ps(cos + i);
+
+		__m128 axisXx = _mm_mul_ps(w, c);
+		__m128 axisXy = _mm_mul_ps(w, s);
+		__m128 axisYx = _mm_mul_ps(h, s); // negated below
+		__m128 axisYy = _mm_mul_ps(h, c);
+
+		StoreCorners4(out, i, 0, stride, _mm_add_ps(_mm_sub_ps(x, axisXx), axisYx), _mm_sub_ps(_mm_sub_ps(y, axisXy), axisYy));
+		StoreCorners4(out, i, 1, stride, _mm_add_ps(_mm_add_ps(x, axisXx), axisYx), _mm_sub_ps(_mm_add_ps(y, axisXy), axisYy));
+		StoreCorners4(out, i, 2, stride, _mm_sub_ps(_mm_add_ps(x, axisXx), axisYx), _mm_add_ps(_mm_add_ps(y, axisXy), axisYy));
+		StoreCorners4(out, i, 3, stride, _mm_sub_ps(_mm_sub_ps(x, axisXx), axisYx), _mm_add_ps(_mm_sub_ps(y, axisXy), axisYy));
+	}
+#endif
+
+	RotatedCornersScalar(cx, cy, hw, hh, sin, cos, i, count, out, stride);
+}
+
+const char* SpriteKernels::GetInstructionSet()
+{
+#if defined(SPRITE_KERNELS_AVX)
+	return "AVX";
+#elif defined(SPRITE_KERNELS_SSE)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
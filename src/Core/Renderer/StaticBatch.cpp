@@ -0,0 +1,162 @@
+#include "Core/Renderer/StaticBatch.h"
+#include <GL/glew.h>
+#include <algorithm>
+#include <cassert>
+
+static int GetTextureSlotsCount()
+{
+	// same limit as the renderer
+
+	static int textureSlots = 0;
+
+	if (textureSlots == 0)
+	{
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &textureSlots);
+		textureSlots = std::min(std::max(textureSlots, 1), 32);
+	}
+
+	return textureSlots;
+}
+
+static Rect Merge(const Rect& a, const Rect& b)
+{
+	return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+}
+
+StaticBatch::StaticBatch()
+{
+	m_capacity = 0;
+	m_dirtyFirst = 0;
+	m_dirtyLast = 0;
+}
+
+void StaticBatch::Clear()
+{
+	// the gpu buffers are kept for the next sprites
+
+	m_sprites.clear();
+	m_slots.clear();
+	m_segmentIndices.clear();
+	m_segments.clear();
+
+	m_dirtyFirst = 0;
+	m_dirtyLast = 0;
+}
+
+void StaticBatch::MarkDirty(uint32_t first, uint32_t last)
+{
+	if (m_dirtyFirst >= m_dirtyLast)
+	{
+		m_dirtyFirst = first;
+		m_dirtyLast = last;
+	}
+	else
+	{
+		m_dirtyFirst = std::min(m_dirtyFirst, first);
+		m_dirtyLast = std::max(m_dirtyLast, last);
+	}
+}
+
+void StaticBatch::AddToSegment(uint32_t index)
+{
+	const QuadCommand& sprite = m_sprites[index];
+	Rect bounds = Rect::FromQuad(sprite.position, sprite.size, sprite.rotation);
+
+	// the last segment takes the sprite while it has the texture or a free slot
+
+	if (!m_segments.empty())
+	{
+		auto& segment = m_segments.back();
+		auto it = std::find(segment.textures.begin(), segment.textures.end(), sprite.texture);
+
+		if (it != segment.textures.end() || (int)segment.textures.size() < GetTextureSlotsCount())
+		{
+			if (it == segment.textures.end())
+				it = segment.textures.insert(segment.textures.end(), sprite.texture);
+
+			m_slots[index] = (int)(it - segment.textures.begin());
+			m_segmentIndices[index] = (uint32_t)m_segments.size() - 1;
+
+			segment.count++;
+			segment.bounds = Merge(segment.bounds, bounds);
+
+			return;
+		}
+	}
+
+	m_segments.push_back({ index, 1, { sprite.texture }, bounds });
+
+	m_slots[index] = 0;
+	m_segmentIndices[index] = (uint32_t)m_segments.size() - 1;
+}
+
+void StaticBatch::Resegment()
+{
+	m_segments.clear();
+
+	for (uint32_t i = 0; i < (uint32_t)m_sprites.size(); i++)
+		AddToSegment(i);
+
+	MarkDirty(0, (uint32_t)m_sprites.size());
+}
+
+uint32_t StaticBatch::Add(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+	return Add(region, position + size * 0.5f, size, 0.0f, color);
+}
+
+uint32_t StaticBatch::Add(const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color)
+{
+	assert(region.GetTexture() != nullptr);
+
+	uint32_t index = (uint32_t)m_sprites.size();
+
+	m_sprites.push_back({ region.GetTexture(), position, size, radians, region.GetTextureRect(), color });
+	m_slots.push_back(0);
+	m_segmentIndices.push_back(0);
+
+	AddToSegment(index);
+	MarkDirty(index, index + 1);
+
+	return index;
+}
+
+void StaticBatch::Set(uint32_t index, const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, const glm::vec4& color)
+{
+	Set(index, region, position + size * 0.5f, size, 0.0f, color);
+}
+
+void StaticBatch::Set(uint32_t index, const TextureRegion& region, const glm::vec2& position, const glm::vec2& size, float radians, const glm::vec4& color)
+{
+	assert(index < m_sprites.size() && region.GetTexture() != nullptr);
+
+	QuadCommand& sprite = m_sprites[index];
+	const Texture* previousTexture = sprite.texture;
+
+	sprite = { region.GetTexture(), position, size, radians, region.GetTextureRect(), color };
+
+	auto& segment = m_segments[m_segmentIndices[index]];
+	segment.bounds = Merge(segment.bounds, Rect::FromQuad(position, size, radians));
+
+	// a new texture goes to a free slot of the segment, without one the segments are rebuilt
+
+	if (sprite.texture != previousTexture)
+	{
+		auto it = std::find(segment.textures.begin(), segment.textures.end(), sprite.texture);
+
+		if (it == segment.textures.end())
+		{
+			if ((int)segment.textures.size() >= GetTextureSlotsCount())
+			{
+				Resegment();
+				return;
+			}
+
+			it = segment.textures.insert(segment.textures.end(), sprite.texture);
+		}
+
+		m_slots[index] = (int)(it - segment.textures.begin());
+	}
+
+	MarkDirty(index, index + 1);
+}
@@ -1,7 +1,48 @@
 #include "Core/Renderer/Texture.h"
 #include <GL/glew.h>
+#include "Core/Renderer/RenderState.h"
+#include "Core/Renderer/TextureFile.h"
+#include "Core/Renderer/ImageKernels.h"
 #include <stb_image/stb_image.h>
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <algorithm>
+
+/* opengl texture parameters of the loaded (and streamed) textures */
+
+static void SetLoadedTextureParameters()
+{
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+/* levels of a full mip chain */
+
+static int GetMipLevels(int width, int height)
+{
+	int levels = 1;
+
+	while ((width | height) >> levels)
+		levels++;
+
+	return levels;
+}
+
+/* gl format of the baked textures */
+
+static unsigned int GetGLFormat(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+	case TextureFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	default: return GL_RGBA8;
+	}
+}
 
 Texture::Texture()
 {
@@ -9,7 +50,15 @@ Texture::Texture()
 	m_width = 0;
 	m_height = 0;
 	m_bpp = 0;
+	m_internalFormat = GL_RGBA8;
+	m_levels = 0;
 	m_pixels = nullptr;
+	m_revision = 0;
+	m_pendingFirstRow = 0;
+	m_pendingLastRow = 0;
+	m_bindlessHandle = 0;
+	m_rendererIndex = -1;
+	m_rendererGeneration = 0;
 }
 
 Texture::Texture(Texture&& other) noexcept
@@ -18,70 +67,108 @@ Texture::Texture(Texture&& other) noexcept
 	m_width = other.m_width;
 	m_height = other.m_height;
 	m_bpp = other.m_bpp;
+	m_internalFormat = other.m_internalFormat;
+	m_levels = other.m_levels;
 	m_path = std::move(other.m_path);
 	m_pixels = other.m_pixels;
+	m_revision = other.m_revision;
+	m_levelPixels = std::move(other.m_levelPixels);
+	m_pendingFirstRow = other.m_pendingFirstRow;
+	m_pendingLastRow = other.m_pendingLastRow;
+	m_bindlessHandle = other.m_bindlessHandle;
+	m_rendererIndex = other.m_rendererIndex;
+	m_rendererGeneration = other.m_rendererGeneration;
 
 	other.m_id = 0;
 	other.m_width = 0;
 	other.m_height = 0;
 	other.m_bpp = 0;
+	other.m_levels = 0;
 	other.m_pixels = nullptr;
+	other.m_bindlessHandle = 0;
+	other.m_rendererIndex = -1;
+	other.m_rendererGeneration = 0;
 }
 
-Texture::Texture(int width, int height)
+Texture::Texture(int width, int height, bool mipmaps) : Texture()
 {
-	Create(width, height);
+	Create(width, height, mipmaps);
 }
 
-Texture::Texture(const std::string& path, bool keepData)
+Texture::Texture(const std::string& path, bool keepData, bool premultiply) : Texture()
 {
-	Load(path, keepData);
+	Load(path, keepData, premultiply);
 }
 
 Texture::~Texture()
 {
+	if (m_bindlessHandle != 0)
+		glMakeTextureHandleNonResidentARB(m_bindlessHandle);
+
+	RenderState::ForgetTexture(m_id);
 	glDeleteTextures(1, &m_id);
 	stbi_image_free(m_pixels);
 
 	std::cout << "[INFO] Texture destroyed \"" << m_path << "\"" << std::endl;
 }
 
-void Texture::Create(int width, int height)
+void Texture::Create(int width, int height, bool mipmaps)
 {
 	// set properties
 
 	m_width = width;
 	m_height = height;
 	m_bpp = 4;
+	m_levels = mipmaps ? GetMipLevels(width, height) : 1;
 	m_pixels = nullptr;
 
 	// opengl create texture
 
 	glGenTextures(1, &m_id);
-	glBindTexture(GL_TEXTURE_2D, m_id);
+	RenderState::BindTexture(GL_TEXTURE_2D, m_id);
 
 	// opengl texture parameters
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mipmaps ? GL_LINEAR : GL_NEAREST);
 
-	// set data
+	// set data, every level allocated when there are mips
+
+	if (mipmaps)
+		glTexStorage2D(GL_TEXTURE_2D, m_levels, GL_RGBA8, width, height);
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	// cpu copy of the levels the mips are built from, transparent like a cleared texture
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	m_levelPixels.clear();
+
+	for (int level = 0; mipmaps && level < m_levels; level++)
+		m_levelPixels.emplace_back((size_t)std::max(width >> level, 1) * std::max(height >> level, 1) * 4, 0);
+
+	m_pendingFirstRow = 0;
+	m_pendingLastRow = 0;
 }
 
-void Texture::Load(const std::string& path, bool keepData)
+void Texture::Load(const std::string& path, bool keepData, bool premultiply)
 {
+	// baked textures
+
+	if (path.size() >= 5 && path.compare(path.size() - 5, 5, ".btex") == 0)
+	{
+		LoadBaked(path, keepData);
+		return;
+	}
+
 	// init
 
 	m_path = path;
 
 	// load image
 
-	stbi_set_flip_vertically_on_load(true);
-	m_pixels = stbi_load(path.c_str(), &m_width, &m_height, &m_bpp, 4);
+	m_pixels = ImageKernels::LoadRGBA(path, &m_width, &m_height, &m_bpp);
 
 	// check if the image is loaded
 
@@ -91,25 +178,30 @@ void Texture::Load(const std::string& path, bool keepData)
 		return;
 	}
 
+	if (premultiply)
+		ImageKernels::PremultiplyAlpha(m_pixels, (size_t)m_width * m_height);
+
 	// if loaded succesfully then create the texture
 
 	glGenTextures(1, &m_id);
-	glBindTexture(GL_TEXTURE_2D, m_id);
+	RenderState::BindTexture(GL_TEXTURE_2D, m_id);
 
-	// opengl texture parameters
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	SetLoadedTextureParameters();
 
 	// set data
 
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_pixels);
+	m_levels = GetMipLevels(m_width, m_height);
+
+	glTexStorage2D(GL_TEXTURE_2D, m_levels, GL_RGBA8, m_width, m_height);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, m_pixels);
+
+	// mipmaps averaged in linear light on the cpu (glGenerateMipmap averages the srgb values of a GL_RGBA8
+	// texture, the mips come out darker), the same filter as the streamed textures
 
-	// generate mipmaps
+	std::vector<TextureMip> mips = TextureFile::GenerateMipLevels(m_width, m_height, m_pixels);
 
-	glGenerateMipmap(GL_TEXTURE_2D);
+	for (int level = 1; level < m_levels; level++)
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mips[level - 1].width, mips[level - 1].height, GL_RGBA, GL_UNSIGNED_BYTE, mips[level - 1].pixels.data());
 
 	// keep or not the pixel data
 
@@ -124,26 +216,197 @@ void Texture::Load(const std::string& path, bool keepData)
 	std::cout << "[INFO] Texture loaded \"" << path << "\"" << std::endl;
 }
 
+void Texture::LoadBaked(const std::string& path, bool keepData)
+{
+	m_path = path;
+
+	TextureFile file;
+
+	if (!file.Open(path))
+	{
+		std::cout << "[ERROR] Texture loading \"" << path << "\"" << std::endl;
+		return;
+	}
+
+	TextureFormat format = file.GetFormat();
+
+	m_width = file.GetWidth();
+	m_height = file.GetHeight();
+	m_bpp = IsCompressedFormat(format) ? 0 : 4;
+	m_internalFormat = GetGLFormat(format);
+	m_levels = file.GetMipCount();
+
+	glGenTextures(1, &m_id);
+	RenderState::BindTexture(GL_TEXTURE_2D, m_id);
+
+	SetLoadedTextureParameters();
+
+	// the levels the file has, a shorter chain stops the sampling at its last level
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+	glTexStorage2D(GL_TEXTURE_2D, m_levels, m_internalFormat, m_width, m_height);
+
+	// straight from the mapped pages, the driver copies them once
+
+	for (int level = 0; level < m_levels; level++)
+	{
+		const TextureFileMip& mip = file.GetMip(level);
+
+		if (IsCompressedFormat(format))
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mip.width, mip.height, m_internalFormat, (GLsizei)mip.size, file.GetMipData(level));
+		else
+			glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, mip.width, mip.height, GL_RGBA, GL_UNSIGNED_BYTE, file.GetMipData(level));
+	}
+
+	// allocated like the stb_image pixels, the destructor frees both the same way
+
+	if (keepData && !IsCompressedFormat(format))
+	{
+		size_t size = file.GetMip(0).size;
+
+		m_pixels = (unsigned char*)malloc(size);
+		std::memcpy(m_pixels, file.GetMipData(0), size);
+	}
+
+	std::cout << "[INFO] Texture loaded \"" << path << "\" (" << GetTextureFormatName(format) << ")" << std::endl;
+}
+
+bool Texture::IsCompressed() const
+{
+	return m_internalFormat != GL_RGBA8;
+}
+
 void Texture::Bind() const
 {
-	glBindTexture(GL_TEXTURE_2D, m_id);
+	RenderState::BindTexture(GL_TEXTURE_2D, m_id);
 }
 
 void Texture::UnBind() const
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	RenderState::BindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture::Active(unsigned int slot) const
 {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, m_id);
+	RenderState::BindTextureUnit(slot, GL_TEXTURE_2D, m_id);
 }
 
 void Texture::SetPixels(int width, int height, const void* pixels)
 {
-	glBindTexture(GL_TEXTURE_2D, m_id);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	SetPixels(0, 0, width, height, pixels);
+}
+
+void Texture::SetPixels(int x, int y, int width, int height, const void* pixels)
+{
+	RenderState::BindTexture(GL_TEXTURE_2D, m_id);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	m_revision++;
+
+	if (m_levelPixels.empty())
+		return;
+
+	// keep the cpu copy and mark the rows, the mips are built once before the texture is drawn
+
+	size_t rowSize = (size_t)width * 4;
+
+	for (int row = 0; row < height; row++)
+		std::memcpy(&m_levelPixels[0][((size_t)(y + row) * m_width + x) * 4], (const unsigned char*)pixels + row * rowSize, rowSize);
+
+	if (!HasPendingMips())
+	{
+		m_pendingFirstRow = y;
+		m_pendingLastRow = y + height;
+	}
+	else
+	{
+		m_pendingFirstRow = std::min(m_pendingFirstRow, y);
+		m_pendingLastRow = std::max(m_pendingLastRow, y + height);
+	}
+}
+
+void Texture::UpdateMips() const
+{
+	if (!HasPendingMips())
+		return;
+
+	RenderState::BindTexture(GL_TEXTURE_2D, m_id);
+
+	// every level only rebuilds the rows under the changed ones of the level before, full rows so the
+	// kernel sees a contiguous image
+
+	int first = m_pendingFirstRow;
+	int last = m_pendingLastRow;
+
+	for (int level = 1; level < m_levels; level++)
+	{
+		int srcWidth = std::max(m_width >> (level - 1), 1);
+		int srcHeight = std::max(m_height >> (level - 1), 1);
+		int width = std::max(srcWidth / 2, 1);
+		int height = std::max(srcHeight / 2, 1);
+
+		first = first / 2;
+		last = std::min((last + 1) / 2, height);
+
+		// the last row of an odd height is not in the next level
+
+		if (first >= last)
+			break;
+
+		int srcRows = std::min(2 * (last - first), srcHeight - 2 * first);
+
+		const unsigned char* src = m_levelPixels[level - 1].data() + (size_t)2 * first * srcWidth * 4;
+		unsigned char* dst = m_levelPixels[level].data() + (size_t)first * width * 4;
+
+		ImageKernels::Downsample2x2(src, srcWidth, srcRows, dst);
+
+		glTexSubImage2D(GL_TEXTURE_2D, level, 0, first, width, last - first, GL_RGBA, GL_UNSIGNED_BYTE, dst);
+	}
+
+	m_pendingFirstRow = 0;
+	m_pendingLastRow = 0;
+	m_revision++;
+}
+
+void Texture::CreateStreamed(const std::string& path, int width, int height)
+{
+	m_path = path;
+	m_width = width;
+	m_height = height;
+	m_bpp = 4;
+	m_pixels = nullptr;
+
+	glGenTextures(1, &m_id);
+	RenderState::BindTexture(GL_TEXTURE_2D, m_id);
+
+	SetLoadedTextureParameters();
+
+	// every level allocated now, the streamer uploads the mips it built after the base level
+
+	m_levels = GetMipLevels(width, height);
+
+	glTexStorage2D(GL_TEXTURE_2D, m_levels, GL_RGBA8, width, height);
+}
+
+void Texture::SetRows(int y, int rows, const void* pixels, int level)
+{
+	RenderState::BindTexture(GL_TEXTURE_2D, m_id);
+	glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, std::max(m_width >> level, 1), rows, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+	m_revision++;
+}
+
+uint64_t Texture::GetBindlessHandle() const
+{
+	if (m_bindlessHandle == 0 && m_id != 0)
+	{
+		// the texture parameters are frozen once the handle is created
+
+		m_bindlessHandle = glGetTextureHandleARB(m_id);
+		glMakeTextureHandleResidentARB(m_bindlessHandle);
+	}
+
+	return m_bindlessHandle;
 }
 
 Texture& Texture::operator=(Texture&& other) noexcept
@@ -156,14 +419,27 @@ Texture& Texture::operator=(Texture&& other) noexcept
 		m_width = other.m_width;
 		m_height = other.m_height;
 		m_bpp = other.m_bpp;
+		m_internalFormat = other.m_internalFormat;
+		m_levels = other.m_levels;
 		m_path = std::move(other.m_path);
 		m_pixels = other.m_pixels;
+		m_revision = other.m_revision;
+		m_levelPixels = std::move(other.m_levelPixels);
+		m_pendingFirstRow = other.m_pendingFirstRow;
+		m_pendingLastRow = other.m_pendingLastRow;
+		m_bindlessHandle = other.m_bindlessHandle;
+		m_rendererIndex = other.m_rendererIndex;
+		m_rendererGeneration = other.m_rendererGeneration;
 
 		other.m_id = 0;
 		other.m_width = 0;
 		other.m_height = 0;
 		other.m_bpp = 0;
+		other.m_levels = 0;
 		other.m_pixels = nullptr;
+		other.m_bindlessHandle = 0;
+		other.m_rendererIndex = -1;
+		other.m_rendererGeneration = 0;
 	}
 
 	return *this;
@@ -0,0 +1,195 @@
+#include "Core/Renderer/TextureAtlas.h"
+#include <GL/glew.h>
+#include "Core/Renderer/ImageKernels.h"
+#include <stb_image/stb_image.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+
+// own copy of the packer, the one compiled in imgui_draw.cpp is static
+
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imgui/imstb_rectpack.h>
+
+struct AtlasPage
+{
+	std::unique_ptr<Texture> texture;
+	stbrp_context context;
+	std::vector<stbrp_node> nodes; // skyline of the packer, one node per column
+	size_t usedArea;
+};
+
+TextureAtlas::TextureAtlas(const TextureAtlasSpecification& specification)
+{
+	m_specification = specification;
+}
+
+TextureAtlas::~TextureAtlas()
+{
+	// out of line, the pages are only complete here
+}
+
+TextureRegion TextureAtlas::Add(int width, int height, const void* pixels)
+{
+	return AddPixels(width, height, (const unsigned char*)pixels, (size_t)width * 4);
+}
+
+TextureRegion TextureAtlas::Add(const std::string& path)
+{
+	int width, height, channels;
+	unsigned char* pixels = ImageKernels::LoadRGBA(path, &width, &height, &channels);
+
+	if (pixels == nullptr)
+	{
+		std::cout << "[ERROR] Texture loading \"" << path << "\"" << std::endl;
+		return TextureRegion();
+	}
+
+	TextureRegion region = AddPixels(width, height, pixels, (size_t)width * 4);
+
+	stbi_image_free(pixels);
+
+	return region;
+}
+
+TextureRegion TextureAtlas::Add(const Texture& texture, const glm::ivec2& srcPosition, const glm::ivec2& srcSize)
+{
+	if (texture.GetPixels() == nullptr)
+	{
+		std::cout << "[ERROR] Texture atlas needs the pixels of \"" << texture.GetPath() << "\", load it with keepData" << std::endl;
+		return TextureRegion();
+	}
+
+	if (srcPosition.x < 0 || srcPosition.y < 0 || srcPosition.x + srcSize.x > texture.GetWidth() || srcPosition.y + srcSize.y > texture.GetHeight())
+	{
+		std::cout << "[ERROR] Texture atlas source rect out of \"" << texture.GetPath() << "\"" << std::endl;
+		return TextureRegion();
+	}
+
+	// the pixels are stored bottom to top, the source rect is measured from the top
+
+	size_t stride = (size_t)texture.GetWidth() * 4;
+	int bottomRow = texture.GetHeight() - srcPosition.y - srcSize.y;
+
+	return AddPixels(srcSize.x, srcSize.y, texture.GetPixels() + bottomRow * stride + srcPosition.x * 4, stride);
+}
+
+void TextureAtlas::Clear()
+{
+	m_pages.clear();
+}
+
+const Texture* TextureAtlas::GetPage(int page) const
+{
+	return m_pages[page]->texture.get();
+}
+
+float TextureAtlas::GetOccupancy(int page) const
+{
+	return (float)m_pages[page]->usedArea / ((float)m_specification.pageWidth * (float)m_specification.pageHeight);
+}
+
+TextureRegion TextureAtlas::AddPixels(int width, int height, const unsigned char* pixels, size_t stride)
+{
+	const int padding = m_specification.padding;
+	const bool bleed = m_specification.bleed;
+
+	if (width <= 0 || height <= 0)
+		return TextureRegion();
+
+	stbrp_rect rect = {};
+	rect.w = width + 2 * padding;
+	rect.h = height + 2 * padding;
+
+	if (rect.w > m_specification.pageWidth || rect.h > m_specification.pageHeight)
+	{
+		std::cout << "[WARNING] Image of " << width << "x" << height << " is bigger than the texture atlas pages" << std::endl;
+		return TextureRegion();
+	}
+
+	// first page with room, a new one when none has it
+
+	AtlasPage* page = nullptr;
+
+	for (auto& candidate : m_pages)
+	{
+		if (stbrp_pack_rects(&candidate->context, &rect, 1) && rect.was_packed)
+		{
+			page = candidate.get();
+			break;
+		}
+	}
+
+	if (page == nullptr)
+	{
+		if ((int)m_pages.size() >= m_specification.maxPages)
+		{
+			std::cout << "[WARNING] Texture atlas is full (" << m_specification.maxPages << " pages)" << std::endl;
+			return TextureRegion();
+		}
+
+		page = AddPage();
+		stbrp_pack_rects(&page->context, &rect, 1); // always fits in an empty page
+	}
+
+	page->usedArea += (size_t)rect.w * rect.h;
+
+	// the image with its padding, bleeding repeats the edge pixels and otherwise it stays transparent
+
+	std::vector<uint32_t> padded((size_t)rect.w * rect.h, 0);
+
+	for (int y = 0; y < rect.h; y++)
+	{
+		int srcY = y - padding;
+
+		if (!bleed && (srcY < 0 || srcY >= height))
+			continue;
+
+		const unsigned char* row = pixels + std::clamp(srcY, 0, height - 1) * stride;
+
+		for (int x = 0; x < rect.w; x++)
+		{
+			int srcX = x - padding;
+
+			if (!bleed && (srcX < 0 || srcX >= width))
+				continue;
+
+			std::memcpy(&padded[(size_t)y * rect.w + x], row + std::clamp(srcX, 0, width - 1) * 4, 4);
+		}
+	}
+
+	// with mipmaps the page only marks the rows, the renderer builds their mips before drawing the page
+
+	page->texture->SetPixels(rect.x, rect.y, rect.w, rect.h, padded.data());
+
+	// the rows go bottom to top, the top of the image is at the top of the packed rect
+
+	glm::vec2 srcPosition = { rect.x + padding, m_specification.pageHeight - (rect.y + padding + height) };
+
+	return TextureRegion(page->texture.get(), srcPosition, { width, height });
+}
+
+AtlasPage* TextureAtlas::AddPage()
+{
+	const int width = m_specification.pageWidth;
+	const int height = m_specification.pageHeight;
+
+	auto page = std::make_unique<AtlasPage>();
+
+	page->texture = std::make_unique<Texture>(width, height, m_specification.mipmaps);
+	page->usedArea = 0;
+
+	// the storage starts undefined, every level cleared so the padding without bleed is transparent
+
+	for (int level = 0; level < page->texture->GetLevels(); level++)
+		glClearTexImage(page->texture->GetId(), level, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+	page->nodes.resize(width);
+	stbrp_init_target(&page->context, width, height, page->nodes.data(), width);
+
+	m_pages.push_back(std::move(page));
+
+	return m_pages.back().get();
+}
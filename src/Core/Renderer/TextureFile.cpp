@@ -0,0 +1,211 @@
+#include "Core/Renderer/TextureFile.h"
+#include "Core/Renderer/ImageKernels.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <iostream>
+
+static const size_t MIP_ALIGNMENT = 16;
+
+static size_t AlignMip(size_t offset)
+{
+	return (offset + MIP_ALIGNMENT - 1) & ~(MIP_ALIGNMENT - 1);
+}
+
+size_t GetTextureFormatSize(TextureFormat format, int width, int height)
+{
+	size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+
+	switch (format)
+	{
+	case TextureFormat::RGBA8:
+		return (size_t)width * height * 4;
+	case TextureFormat::BC1:
+		return blocks * 8;
+	case TextureFormat::BC3:
+		return blocks * 16;
+	default:
+		return 0;
+	}
+}
+
+bool IsCompressedFormat(TextureFormat format)
+{
+	return format == TextureFormat::BC1 || format == TextureFormat::BC3;
+}
+
+const char* GetTextureFormatName(TextureFormat format)
+{
+	switch (format)
+	{
+	case TextureFormat::RGBA8: return "RGBA8";
+	case TextureFormat::BC1: return "BC1";
+	case TextureFormat::BC3: return "BC3";
+	default: return "unknown";
+	}
+}
+
+/* TEXTURE FILE */
+
+TextureFile::TextureFile()
+{
+	m_header = nullptr;
+	m_mips = nullptr;
+}
+
+bool TextureFile::Open(const std::string& path)
+{
+	Close();
+
+	if (!m_file.Open(path))
+		return false;
+
+	const unsigned char* data = m_file.GetData();
+	size_t size = m_file.GetSize();
+
+	// header, the dimensions are not zero and the mip count is at most the one of a full chain
+
+	const TextureFileHeader* header = (const TextureFileHeader*)data;
+	bool valid = size >= sizeof(TextureFileHeader) && header->magic == TEXTURE_FILE_MAGIC && header->version == TEXTURE_FILE_VERSION && GetTextureFormatSize((TextureFormat)header->format, 1, 1) != 0 &&
+		header->width > 0 && header->height > 0;
+
+	if (valid)
+	{
+		uint32_t maxMipCount = 1;
+
+		while ((header->width | header->height) >> maxMipCount)
+			maxMipCount++;
+
+		valid = header->mipCount > 0 && header->mipCount <= maxMipCount;
+	}
+
+	if (!valid)
+	{
+		std::cout << "[ERROR] Texture file header \"" << path << "\"" << std::endl;
+
+		Close();
+		return false;
+	}
+
+	// mips, every one inside the file with the size its format and dimensions need
+
+	const TextureFileMip* mips = (const TextureFileMip*)(data + sizeof(TextureFileHeader));
+
+	valid = sizeof(TextureFileHeader) + header->mipCount * sizeof(TextureFileMip) <= size;
+
+	for (uint32_t i = 0; valid && i < header->mipCount; i++)
+	{
+		const TextureFileMip& mip = mips[i];
+
+		valid = mip.offset <= size && mip.size <= size - mip.offset && mip.width == std::max(header->width >> i, 1u) && mip.height == std::max(header->height >> i, 1u) &&
+			mip.size == GetTextureFormatSize((TextureFormat)header->format, mip.width, mip.height);
+	}
+
+	if (!valid)
+	{
+		std::cout << "[ERROR] Texture file mips \"" << path << "\"" << std::endl;
+
+		Close();
+		return false;
+	}
+
+	m_header = header;
+	m_mips = mips;
+
+	return true;
+}
+
+void TextureFile::Close()
+{
+	m_file.Close();
+	m_header = nullptr;
+	m_mips = nullptr;
+}
+
+std::vector<TextureMip> TextureFile::GenerateMips(int width, int height, const unsigned char* pixels, bool mips, bool srgb)
+{
+	std::vector<TextureMip> chain;
+
+	chain.push_back({ width, height, std::vector<unsigned char>(pixels, pixels + (size_t)width * height * 4) });
+
+	if (mips)
+	{
+		for (TextureMip& mip : GenerateMipLevels(width, height, pixels, srgb))
+			chain.push_back(std::move(mip));
+	}
+
+	return chain;
+}
+
+std::vector<TextureMip> TextureFile::GenerateMipLevels(int width, int height, const unsigned char* pixels, bool srgb)
+{
+	std::vector<TextureMip> levels;
+
+	// every level is the 2x2 average of the one before
+
+	while (width > 1 || height > 1)
+	{
+		TextureMip mip;
+		mip.width = std::max(width / 2, 1);
+		mip.height = std::max(height / 2, 1);
+		mip.pixels.resize((size_t)mip.width * mip.height * 4);
+
+		ImageKernels::Downsample2x2(pixels, width, height, mip.pixels.data(), srgb);
+
+		levels.push_back(std::move(mip));
+
+		width = levels.back().width;
+		height = levels.back().height;
+		pixels = levels.back().pixels.data();
+	}
+
+	return levels;
+}
+
+bool TextureFile::Save(const std::string& path, TextureFormat format, const std::vector<TextureMip>& mips)
+{
+	if (mips.empty())
+		return false;
+
+	TextureFileHeader header = {};
+	header.magic = TEXTURE_FILE_MAGIC;
+	header.version = TEXTURE_FILE_VERSION;
+	header.format = (uint32_t)format;
+	header.width = (uint32_t)mips[0].width;
+	header.height = (uint32_t)mips[0].height;
+	header.mipCount = (uint32_t)mips.size();
+
+	// table
+
+	std::vector<TextureFileMip> table(mips.size());
+	size_t offset = AlignMip(sizeof(TextureFileHeader) + mips.size() * sizeof(TextureFileMip));
+
+	for (size_t i = 0; i < mips.size(); i++)
+	{
+		table[i] = { offset, mips[i].pixels.size(), (uint32_t)mips[i].width, (uint32_t)mips[i].height };
+		offset = AlignMip(offset + mips[i].pixels.size());
+	}
+
+	// write
+
+	std::ofstream file(path, std::ios::binary);
+
+	if (!file.is_open())
+	{
+		std::cout << "[ERROR] Texture file writing \"" << path << "\"" << std::endl;
+		return false;
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)table.data(), table.size() * sizeof(TextureFileMip));
+
+	const char zeros[MIP_ALIGNMENT] = {};
+
+	for (size_t i = 0; i < mips.size(); i++)
+	{
+		file.write(zeros, table[i].offset - (size_t)file.tellp());
+		file.write((const char*)mips[i].pixels.data(), mips[i].pixels.size());
+	}
+
+	return file.good();
+}
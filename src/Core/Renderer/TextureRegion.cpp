@@ -0,0 +1,35 @@
+#include "Core/Renderer/TextureRegion.h"
+
+TextureRegion::TextureRegion()
+{
+	m_texture = nullptr;
+	m_textureRect = { 0.0f, 0.0f, 0.0f, 0.0f };
+	m_size = { 0.0f, 0.0f };
+}
+
+TextureRegion::TextureRegion(const Texture* texture) : TextureRegion()
+{
+	if (texture != nullptr)
+		Set(texture, { 0.0f, 0.0f }, { texture->GetWidth(), texture->GetHeight() });
+}
+
+TextureRegion::TextureRegion(const Texture* texture, const glm::vec2& srcPosition, const glm::vec2& srcSize) : TextureRegion()
+{
+	Set(texture, srcPosition, srcSize);
+}
+
+void TextureRegion::Set(const Texture* texture, const glm::vec2& srcPosition, const glm::vec2& srcSize)
+{
+	m_texture = texture;
+	m_size = srcSize;
+
+	if (texture == nullptr || texture->GetWidth() == 0 || texture->GetHeight() == 0)
+		return;
+
+	// normalize once so drawing the region does not divide by the texture size (v is flipped, the textures are loaded upside down)
+
+	float width = (float)texture->GetWidth();
+	float height = (float)texture->GetHeight();
+
+	m_textureRect = { srcPosition.x / width, 1 - srcPosition.y / height, srcSize.x / width, -srcSize.y / height };
+}
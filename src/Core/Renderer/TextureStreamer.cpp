@@ -0,0 +1,366 @@
+#include "Core/Renderer/TextureStreamer.h"
+#include <GL/glew.h>
+#include "Core/Renderer/Texture.h"
+#include "Core/Renderer/TextureFile.h"
+#include "Core/Renderer/Buffer.h"
+#include "Core/Renderer/ImageKernels.h"
+#include "Core/ThreadPool.h"
+#include <stb_image/stb_image.h>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+struct StreamRequest
+{
+	uint32_t id;
+	std::string path;
+	glm::vec2 position;
+	StreamState state; // only touched by the main thread
+
+	// written by the decode task before it sets decoded
+
+	std::atomic<bool> decoded = false;
+	std::atomic<bool> cancelled = false;
+	unsigned char* pixels = nullptr;
+	int width = 0;
+	int height = 0;
+	std::vector<TextureMip> mips; // levels 1 to the last
+
+	// upload, level by level
+
+	int uploadLevel = 0;
+	int uploadedRows = 0;
+	std::unique_ptr<Texture> texture;
+
+	~StreamRequest() { stbi_image_free(pixels); }
+};
+
+struct TextureStreamerData
+{
+	TextureStreamerSpecification specification;
+
+	std::unique_ptr<ThreadPool> threadPool;
+	std::unique_ptr<PixelUnpackBuffer> unpackBuffer;
+	std::unique_ptr<Texture> placeholder;
+
+	// the decode tasks keep their request alive, a request cancelled while decoding is freed by the task
+
+	std::unordered_map<uint32_t, std::shared_ptr<StreamRequest>> requests;
+	std::vector<std::shared_ptr<StreamRequest>> pending; // queued, decoding or uploading
+	std::atomic<int> decodesInFlight = 0;
+	uint32_t nextId = 1;
+
+	TextureStreamerStats stats;
+};
+
+static TextureStreamerData sd;
+
+static StreamRequest* FindRequest(StreamedTexture handle)
+{
+	auto it = sd.requests.find(handle.id);
+
+	return it != sd.requests.end() ? it->second.get() : nullptr;
+}
+
+/* worker threads */
+
+static void DecodeImage(const std::shared_ptr<StreamRequest>& request)
+{
+	if (!request->cancelled)
+	{
+		int channels;
+		request->pixels = ImageKernels::LoadRGBA(request->path, &request->width, &request->height, &channels);
+
+		// the mips are built here so the main thread only copies them
+
+		if (request->pixels != nullptr)
+			request->mips = TextureFile::GenerateMipLevels(request->width, request->height, request->pixels);
+	}
+
+	request->decoded.store(true, std::memory_order_release);
+	sd.decodesInFlight--;
+}
+
+/* main thread */
+
+static void UploadDecodedImages()
+{
+	unsigned char* region = nullptr;
+	size_t regionUsed = 0;
+	size_t regionSize = sd.unpackBuffer->GetRegionSize();
+	bool budgetLeft = true;
+
+	for (auto& request : sd.pending)
+	{
+		if (!budgetLeft)
+			break;
+
+		if (request->state != StreamState::UPLOADING)
+			continue;
+
+		int levels = (int)request->mips.size() + 1;
+
+		while (request->uploadLevel < levels)
+		{
+			int level = request->uploadLevel;
+			int width = std::max(request->width >> level, 1);
+			int height = std::max(request->height >> level, 1);
+			const unsigned char* pixels = level == 0 ? request->pixels : request->mips[level - 1].pixels.data();
+
+			size_t rowSize = (size_t)width * 4;
+			size_t uploadedSize = 0;
+
+			if (rowSize > regionSize)
+			{
+				// a single row is over the budget, uploaded straight from memory
+
+				sd.unpackBuffer->UnBind();
+				request->texture->SetRows(0, height, pixels, level);
+
+				uploadedSize = rowSize * height;
+				request->uploadedRows = height;
+			}
+			else
+			{
+				// as many rows as fit in what is left of the region of this frame
+
+				int rows = std::min(height - request->uploadedRows, (int)((regionSize - regionUsed) / rowSize));
+
+				if (rows == 0)
+				{
+					budgetLeft = false;
+					break;
+				}
+
+				if (region == nullptr)
+					region = (unsigned char*)sd.unpackBuffer->LockRegion();
+
+				uploadedSize = rows * rowSize;
+				std::memcpy(region + regionUsed, pixels + request->uploadedRows * rowSize, uploadedSize);
+
+				sd.unpackBuffer->Bind();
+				request->texture->SetRows(request->uploadedRows, rows, (const void*)(sd.unpackBuffer->GetRegionOffset() + regionUsed), level);
+
+				regionUsed += uploadedSize;
+				request->uploadedRows += rows;
+			}
+
+			sd.stats.bytesUploaded += uploadedSize;
+
+			if (request->uploadedRows == height)
+			{
+				request->uploadLevel++;
+				request->uploadedRows = 0;
+			}
+		}
+
+		if (request->uploadLevel == levels)
+		{
+			stbi_image_free(request->pixels);
+			request->pixels = nullptr;
+			request->mips.clear();
+			request->state = StreamState::READY;
+
+			std::cout << "[INFO] Texture streamed \"" << request->path << "\"" << std::endl;
+		}
+	}
+
+	// unbound so the uploads from client memory keep working
+
+	sd.unpackBuffer->UnBind();
+
+	if (region != nullptr)
+		sd.unpackBuffer->UnlockRegion();
+}
+
+/* TEXTURE STREAMER */
+
+void TextureStreamer::Init(const TextureStreamerSpecification& specification)
+{
+	sd.specification = specification;
+	sd.specification.decodeThreads = std::max(specification.decodeThreads, 1);
+
+	sd.threadPool = std::make_unique<ThreadPool>(sd.specification.decodeThreads);
+
+	sd.unpackBuffer = std::make_unique<PixelUnpackBuffer>();
+	sd.unpackBuffer->Create(specification.uploadBudget, specification.uploadRegions);
+
+	// gray checkerboard
+
+	uint32_t pixels[8 * 8];
+
+	for (int y = 0; y < 8; y++)
+	{
+		for (int x = 0; x < 8; x++)
+			pixels[y * 8 + x] = ((x / 4 + y / 4) % 2) ? 0xFF808080 : 0xFF606060;
+	}
+
+	sd.placeholder = std::make_unique<Texture>(8, 8);
+	sd.placeholder->SetPixels(8, 8, pixels);
+}
+
+void TextureStreamer::Destroy()
+{
+	for (auto& request : sd.pending)
+		request->cancelled = true;
+
+	// waits for the decodes that already started
+
+	sd.threadPool.reset();
+
+	sd.pending.clear();
+	sd.requests.clear();
+	sd.unpackBuffer.reset();
+	sd.placeholder.reset();
+	sd.stats = TextureStreamerStats();
+}
+
+StreamedTexture TextureStreamer::Load(const std::string& path, const glm::vec2& position)
+{
+	auto request = std::make_shared<StreamRequest>();
+	request->id = sd.nextId++;
+	request->path = path;
+	request->position = position;
+	request->state = StreamState::QUEUED;
+
+	sd.requests[request->id] = request;
+	sd.pending.push_back(request);
+
+	return { request->id };
+}
+
+void TextureStreamer::SetPosition(StreamedTexture handle, const glm::vec2& position)
+{
+	StreamRequest* request = FindRequest(handle);
+
+	if (request != nullptr)
+		request->position = position;
+}
+
+void TextureStreamer::Cancel(StreamedTexture handle)
+{
+	auto it = sd.requests.find(handle.id);
+
+	if (it == sd.requests.end())
+		return;
+
+	std::shared_ptr<StreamRequest> request = std::move(it->second);
+	sd.requests.erase(it);
+
+	// a decode that already started finishes and its task frees the pixels
+
+	request->cancelled = true;
+	sd.pending.erase(std::remove(sd.pending.begin(), sd.pending.end(), request), sd.pending.end());
+}
+
+StreamState TextureStreamer::GetState(StreamedTexture handle)
+{
+	StreamRequest* request = FindRequest(handle);
+
+	return request != nullptr ? request->state : StreamState::NONE;
+}
+
+const Texture* TextureStreamer::Get(StreamedTexture handle)
+{
+	StreamRequest* request = FindRequest(handle);
+
+	if (request != nullptr && request->state == StreamState::READY)
+		return request->texture.get();
+
+	return sd.placeholder.get();
+}
+
+const Texture* TextureStreamer::GetPlaceholder()
+{
+	return sd.placeholder.get();
+}
+
+void TextureStreamer::Update(const glm::vec2& viewCenter)
+{
+	sd.stats.bytesUploaded = 0;
+
+	// closest to the view first, for both the decodes and the uploads
+
+	std::sort(sd.pending.begin(), sd.pending.end(), [&](const auto& a, const auto& b)
+		{
+			glm::vec2 da = a->position - viewCenter;
+			glm::vec2 db = b->position - viewCenter;
+
+			return glm::dot(da, da) < glm::dot(db, db);
+		});
+
+	// a couple of decodes per thread, not the whole queue, so a texture that gets closer is not stuck
+	// behind the ones queued before it
+
+	int maxDecodes = 2 * sd.specification.decodeThreads;
+
+	for (auto& request : sd.pending)
+	{
+		if (sd.decodesInFlight >= maxDecodes)
+			break;
+
+		if (request->state != StreamState::QUEUED)
+			continue;
+
+		request->state = StreamState::DECODING;
+		sd.decodesInFlight++;
+
+		sd.threadPool->PushTask([request]() { DecodeImage(request); });
+	}
+
+	// decoded images get their texture storage
+
+	for (auto& request : sd.pending)
+	{
+		if (request->state != StreamState::DECODING || !request->decoded.load(std::memory_order_acquire))
+			continue;
+
+		if (request->pixels == nullptr)
+		{
+			std::cout << "[ERROR] Texture loading \"" << request->path << "\"" << std::endl;
+
+			request->state = StreamState::FAILED;
+			continue;
+		}
+
+		request->texture = std::make_unique<Texture>();
+		request->texture->CreateStreamed(request->path, request->width, request->height);
+		request->state = StreamState::UPLOADING;
+	}
+
+	UploadDecodedImages();
+
+	// finished requests leave the pending list
+
+	sd.pending.erase(std::remove_if(sd.pending.begin(), sd.pending.end(), [](const auto& request)
+		{
+			return request->state == StreamState::READY || request->state == StreamState::FAILED;
+		}), sd.pending.end());
+
+	// stats
+
+	TextureStreamerStats& stats = sd.stats;
+	stats.queued = stats.decoding = stats.uploading = stats.ready = stats.failed = 0;
+
+	for (auto& [id, request] : sd.requests)
+	{
+		switch (request->state)
+		{
+		case StreamState::QUEUED: stats.queued++; break;
+		case StreamState::DECODING: stats.decoding++; break;
+		case StreamState::UPLOADING: stats.uploading++; break;
+		case StreamState::READY: stats.ready++; break;
+		case StreamState::FAILED: stats.failed++; break;
+		default: break;
+		}
+	}
+}
+
+const TextureStreamerStats& TextureStreamer::GetStats()
+{
+	return sd.stats;
+}
@@ -1,25 +1,45 @@
 #include "Core/Renderer/VertexArray.h"
 #include <GL/glew.h>
+#include "Core/Renderer/RenderState.h"
 #include <cassert>
 
 VertexArray::VertexArray()
 {
 	m_id = 0;
+	m_attributesCount = 0;
 }
 
 VertexArray::~VertexArray()
 {
+	RenderState::ForgetVertexArray(m_id);
 	glDeleteVertexArrays(1, &m_id);
 }
 
+void VertexArray::Create()
+{
+	assert(m_id == 0);
+
+	glGenVertexArrays(1, &m_id);
+}
+
 void VertexArray::Create(const VertexBuffer& vb, const VertexBufferLayout& layout)
 {
 	assert(m_id == 0);
 
-	// create and bind vertex array
+	// create vertex array
 
 	glGenVertexArrays(1, &m_id);
-	glBindVertexArray(m_id);
+
+	// add the vertex buffer
+
+	AddVertexBuffer(vb, layout);
+}
+
+void VertexArray::AddVertexBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+	assert(m_id != 0);
+
+	RenderState::BindVertexArray(m_id);
 
 	// bind vertex buffer
 
@@ -29,25 +49,32 @@ void VertexArray::Create(const VertexBuffer& vb, const VertexBufferLayout& layou
 
 	auto& elements = layout.GetElements();
 	size_t stride = layout.GetStride();
-	size_t offset = 0;
 
 	for (unsigned int i = 0; i < elements.size(); i++)
 	{
 		auto& e = elements[i];
 
-		glEnableVertexAttribArray(i);
-		glVertexAttribPointer(i, e.count, e.type, GL_FALSE, stride, (const void*)offset);
+		// attributes continue after the ones of the previous buffers
+
+		unsigned int location = m_attributesCount++;
+
+		glEnableVertexAttribArray(location);
+
+		if (e.integer)
+			glVertexAttribIPointer(location, e.count, e.type, stride, (const void*)e.offset);
+		else
+			glVertexAttribPointer(location, e.count, e.type, e.normalized ? GL_TRUE : GL_FALSE, stride, (const void*)e.offset);
 
-		offset += e.count * e.elementSize;
+		glVertexAttribDivisor(location, layout.GetDivisor());
 	}
 }
 
 void VertexArray::Bind() const
 {
-	glBindVertexArray(m_id);
+	RenderState::BindVertexArray(m_id);
 }
 
 void VertexArray::UnBind() const
 {
-	glBindVertexArray(0);
+	RenderState::BindVertexArray(0);
 }
@@ -4,6 +4,7 @@ ThreadPool::ThreadPool(int threadsCount)
 {
 	m_workersCount = threadsCount;
 	m_working = true;
+	m_pendingTasks = 0;
 
 	for (int i = 0; i < m_workersCount; i++)
 		m_workers.push_back(std::thread(&ThreadPool::DoWork, this));
@@ -33,6 +34,7 @@ void ThreadPool::PushTask(const std::function<void()>& task)
 	{
 		std::scoped_lock lock(m_tasksMutex);
 		m_tasks.push(task);
+		m_pendingTasks++;
 	}
 
 	// notify that one task has been added
@@ -40,6 +42,15 @@ void ThreadPool::PushTask(const std::function<void()>& task)
 	m_condition.notify_one();
 }
 
+void ThreadPool::Wait()
+{
+	std::unique_lock lock(m_tasksMutex);
+	m_doneCondition.wait(lock, [&]()
+		{
+			return m_pendingTasks == 0;
+		});
+}
+
 void ThreadPool::DoWork()
 {
 	while (true)
@@ -69,6 +80,13 @@ void ThreadPool::DoWork()
 			// do the task
 
 			task();
+
+			// notify the waiting threads when it was the last one
+
+			lock.lock();
+
+			if (--m_pendingTasks == 0)
+				m_doneCondition.notify_all();
 		}
 		else
 		{
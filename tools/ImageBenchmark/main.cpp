@@ -0,0 +1,144 @@
+// times the image kernels (Core/Renderer/ImageKernels.h) against their scalar reference on a random
+// image and checks that both give the same bytes
+//
+// usage: ImageBenchmark [width] [height] [iterations]
+//
+// build from the root of the repository, once per instruction set to compare (-msse2, -mssse3, -mavx2):
+// g++ -std=c++17 -O2 -mavx2 -Iinclude -Ivendor tools/ImageBenchmark/main.cpp src/Core/Renderer/ImageKernels.cpp
+//     vendor/stb_image/stb_image.cpp -o ImageBenchmark
+
+#include "Core/Renderer/ImageKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+struct BenchmarkResult
+{
+	double scalarMs;
+	double simdMs;
+	bool equal;
+};
+
+// best of the iterations after a warm up run (caches, page faults and the srgb tables built on first use),
+// the input is restored before every run so the in place kernels see the same pixels
+
+static double Time(const std::function<void()>& restore, const std::function<void()>& kernel, int iterations)
+{
+	double best = 1e30;
+
+	restore();
+	kernel();
+
+	for (int i = 0; i < iterations; i++)
+	{
+		restore();
+
+		auto start = std::chrono::steady_clock::now();
+		kernel();
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		best = std::min(best, ms);
+	}
+
+	return best;
+}
+
+static void Report(const std::string& name, size_t bytes, const BenchmarkResult& result)
+{
+	double scalarGBs = bytes / (result.scalarMs * 1e6);
+	double simdGBs = bytes / (result.simdMs * 1e6);
+
+	std::cout << "[INFO] " << name << ": scalar " << result.scalarMs << " ms (" << scalarGBs << " GB/s), simd " << result.simdMs << " ms (" << simdGBs << " GB/s), "
+		<< result.scalarMs / result.simdMs << "x" << (result.equal ? "" : " MISMATCH") << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+	int width = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 2048;
+	int height = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 2048;
+	int iterations = argc > 3 ? std::max(std::atoi(argv[3]), 1) : 20;
+
+	size_t count = (size_t)width * height;
+
+	std::mt19937 random(1234);
+	std::vector<unsigned char> source(count * 4);
+
+	for (unsigned char& byte : source)
+		byte = (unsigned char)(random() & 0xFF);
+
+	std::vector<unsigned char> a(count * 4), b(count * 4);
+	auto restoreA = [&]() { std::memcpy(a.data(), source.data(), source.size()); };
+	auto restoreB = [&]() { std::memcpy(b.data(), source.data(), source.size()); };
+	auto nothing = []() {};
+
+	std::cout << "[INFO] " << width << "x" << height << ", " << iterations << " iterations, " << ImageKernels::GetInstructionSet() << std::endl;
+
+	bool allEqual = true;
+
+	// in place kernels
+
+	{
+		BenchmarkResult result;
+		result.scalarMs = Time(restoreA, [&]() { ImageKernels::Scalar::FlipVertical(a.data(), (size_t)width * 4, height); }, iterations);
+		result.simdMs = Time(restoreB, [&]() { ImageKernels::FlipVertical(b.data(), (size_t)width * 4, height); }, iterations);
+		result.equal = a == b;
+
+		Report("FlipVertical", count * 4, result);
+		allEqual &= result.equal;
+	}
+
+	{
+		BenchmarkResult result;
+		result.scalarMs = Time(restoreA, [&]() { ImageKernels::Scalar::PremultiplyAlpha(a.data(), count); }, iterations);
+		result.simdMs = Time(restoreB, [&]() { ImageKernels::PremultiplyAlpha(b.data(), count); }, iterations);
+		result.equal = a == b;
+
+		Report("PremultiplyAlpha", count * 4, result);
+		allEqual &= result.equal;
+	}
+
+	{
+		const int order[4] = { 2, 1, 0, 3 };
+
+		BenchmarkResult result;
+		result.scalarMs = Time(restoreA, [&]() { ImageKernels::Scalar::Swizzle(a.data(), count, order); }, iterations);
+		result.simdMs = Time(restoreB, [&]() { ImageKernels::Swizzle(b.data(), count, order); }, iterations);
+		result.equal = a == b;
+
+		Report("Swizzle", count * 4, result);
+		allEqual &= result.equal;
+	}
+
+	// the source (the first 3/4 of it as rgb) stays untouched
+
+	{
+		BenchmarkResult result;
+		result.scalarMs = Time(nothing, [&]() { ImageKernels::Scalar::ExpandRGBToRGBA(source.data(), count, a.data()); }, iterations);
+		result.simdMs = Time(nothing, [&]() { ImageKernels::ExpandRGBToRGBA(source.data(), count, b.data()); }, iterations);
+		result.equal = a == b;
+
+		Report("ExpandRGBToRGBA", count * 3, result);
+		allEqual &= result.equal;
+	}
+
+	for (bool srgb : { false, true })
+	{
+		size_t mipSize = (size_t)std::max(width / 2, 1) * std::max(height / 2, 1) * 4;
+
+		BenchmarkResult result;
+		result.scalarMs = Time(nothing, [&]() { ImageKernels::Scalar::Downsample2x2(source.data(), width, height, a.data(), srgb); }, iterations);
+		result.simdMs = Time(nothing, [&]() { ImageKernels::Downsample2x2(source.data(), width, height, b.data(), srgb); }, iterations);
+		result.equal = std::memcmp(a.data(), b.data(), mipSize) == 0;
+
+		Report(srgb ? "Downsample2x2 (srgb)" : "Downsample2x2 (linear)", count * 4, result);
+		allEqual &= result.equal;
+	}
+
+	return allEqual ? 0 : 1;
+}
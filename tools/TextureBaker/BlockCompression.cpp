@@ -0,0 +1,499 @@
+#include "BlockCompression.h"
+#include "Core/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/* colors */
+
+static uint16_t PackRGB565(const float color[3])
+{
+	int r = (int)std::lround(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f);
+	int g = (int)std::lround(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f);
+	int b = (int)std::lround(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f);
+
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void UnpackRGB565(uint16_t packed, int color[3])
+{
+	int r = (packed >> 11) & 31;
+	int g = (packed >> 5) & 63;
+	int b = packed & 31;
+
+	// the bits repeated like the hardware expands them
+
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+}
+
+// four colors when c0 > c1, otherwise three and transparent black (BC3 always reads four)
+
+static void GetColorPalette(uint16_t c0, uint16_t c1, bool fourColors, int palette[4][4])
+{
+	UnpackRGB565(c0, palette[0]);
+	UnpackRGB565(c1, palette[1]);
+
+	for (int c = 0; c < 3; c++)
+	{
+		if (fourColors)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	palette[0][3] = palette[1][3] = palette[2][3] = 255;
+	palette[3][3] = fourColors ? 255 : 0;
+}
+
+/* color block */
+
+struct ColorBlock
+{
+	float pixels[16][3];
+	bool opaque[16];
+	bool transparent; // has pixels for the transparent index
+};
+
+struct ColorFit
+{
+	uint16_t c0, c1;
+	uint32_t indices;
+	float error;
+};
+
+static void GetPrincipalEndpoints(const ColorBlock& block, float e0[3], float e1[3])
+{
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	int count = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		if (!block.opaque[i])
+			continue;
+
+		for (int c = 0; c < 3; c++)
+			mean[c] += block.pixels[i][c];
+
+		count++;
+	}
+
+	for (int c = 0; c < 3; c++)
+		mean[c] /= (float)count;
+
+	// covariance and its main axis by power iteration
+
+	float cov[6] = {};
+
+	for (int i = 0; i < 16; i++)
+	{
+		if (!block.opaque[i])
+			continue;
+
+		float r = block.pixels[i][0] - mean[0];
+		float g = block.pixels[i][1] - mean[1];
+		float b = block.pixels[i][2] - mean[2];
+
+		cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+		cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+	}
+
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+		float length = std::max(std::abs(x), std::max(std::abs(y), std::abs(z)));
+
+		if (length < 1e-6f)
+			break;
+
+		axis[0] = x / length;
+		axis[1] = y / length;
+		axis[2] = z / length;
+	}
+
+	// extremes of the pixels projected on the axis
+
+	float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	float minT = 0.0f, maxT = 0.0f;
+
+	for (int i = 0; i < 16; i++)
+	{
+		if (!block.opaque[i])
+			continue;
+
+		float t = ((block.pixels[i][0] - mean[0]) * axis[0] + (block.pixels[i][1] - mean[1]) * axis[1] + (block.pixels[i][2] - mean[2]) * axis[2]) / axisLength2;
+
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+
+	for (int c = 0; c < 3; c++)
+	{
+		e0[c] = mean[c] + axis[c] * maxT;
+		e1[c] = mean[c] + axis[c] * minT;
+	}
+}
+
+static ColorFit FitColorIndices(const ColorBlock& block, uint16_t c0, uint16_t c1, bool fourColorMode)
+{
+	// the mode is given by the order of the endpoints, equal endpoints decode as three colors in BC1
+
+	if (fourColorMode ? c0 < c1 : c0 > c1)
+		std::swap(c0, c1);
+
+	bool fourColors = c0 > c1;
+	int candidates = fourColors ? 4 : 3;
+
+	int palette[4][4];
+	GetColorPalette(c0, c1, fourColors, palette);
+
+	ColorFit fit = { c0, c1, 0, 0.0f };
+
+	for (int i = 0; i < 16; i++)
+	{
+		uint32_t index = 3;
+
+		if (block.opaque[i])
+		{
+			float bestError = 1e30f;
+
+			for (int p = 0; p < candidates; p++)
+			{
+				float dr = block.pixels[i][0] - palette[p][0];
+				float dg = block.pixels[i][1] - palette[p][1];
+				float db = block.pixels[i][2] - palette[p][2];
+				float error = dr * dr + dg * dg + db * db;
+
+				if (error < bestError)
+				{
+					bestError = error;
+					index = p;
+				}
+			}
+
+			fit.error += bestError;
+		}
+
+		fit.indices |= index << (2 * i);
+	}
+
+	return fit;
+}
+
+static bool RefineEndpoints(const ColorBlock& block, const ColorFit& fit, bool fourColorMode, float e0[3], float e1[3])
+{
+	// least squares endpoints for the indices chosen, each pixel is a * e0 + b * e1
+
+	static const float FOUR_COLOR_WEIGHTS[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+	static const float THREE_COLOR_WEIGHTS[4] = { 1.0f, 0.0f, 0.5f, 0.0f };
+
+	const float* weights = fourColorMode ? FOUR_COLOR_WEIGHTS : THREE_COLOR_WEIGHTS;
+
+	float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+	float ax[3] = {}, bx[3] = {};
+
+	for (int i = 0; i < 16; i++)
+	{
+		int index = (fit.indices >> (2 * i)) & 3;
+
+		if (!block.opaque[i] || (!fourColorMode && index == 3))
+			continue;
+
+		float a = weights[index];
+		float b = 1.0f - a;
+
+		aa += a * a;
+		bb += b * b;
+		ab += a * b;
+
+		for (int c = 0; c < 3; c++)
+		{
+			ax[c] += a * block.pixels[i][c];
+			bx[c] += b * block.pixels[i][c];
+		}
+	}
+
+	float det = aa * bb - ab * ab;
+
+	if (std::abs(det) < 1e-6f)
+		return false;
+
+	for (int c = 0; c < 3; c++)
+	{
+		e0[c] = (ax[c] * bb - bx[c] * ab) / det;
+		e1[c] = (bx[c] * aa - ax[c] * ab) / det;
+	}
+
+	return true;
+}
+
+static void EncodeColorBlock(const uint8_t rgba[64], uint8_t block[8], bool allowTransparent)
+{
+	ColorBlock colors;
+	colors.transparent = false;
+
+	int opaqueCount = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+			colors.pixels[i][c] = (float)rgba[i * 4 + c];
+
+		colors.opaque[i] = !allowTransparent || rgba[i * 4 + 3] >= 128;
+		colors.transparent |= !colors.opaque[i];
+		opaqueCount += colors.opaque[i];
+	}
+
+	ColorFit best;
+
+	if (opaqueCount == 0)
+	{
+		// three color mode with every pixel on the transparent index
+
+		best = { 0, 0, 0xFFFFFFFF, 0.0f };
+	}
+	else
+	{
+		bool fourColorMode = !colors.transparent;
+
+		float e0[3], e1[3];
+		GetPrincipalEndpoints(colors, e0, e1);
+
+		best = FitColorIndices(colors, PackRGB565(e0), PackRGB565(e1), fourColorMode);
+
+		for (int iteration = 0; iteration < 2 && best.error > 0.0f; iteration++)
+		{
+			if (!RefineEndpoints(colors, best, fourColorMode, e0, e1))
+				break;
+
+			ColorFit fit = FitColorIndices(colors, PackRGB565(e0), PackRGB565(e1), fourColorMode);
+
+			if (fit.error >= best.error)
+				break;
+
+			best = fit;
+		}
+	}
+
+	block[0] = (uint8_t)(best.c0 & 0xFF);
+	block[1] = (uint8_t)(best.c0 >> 8);
+	block[2] = (uint8_t)(best.c1 & 0xFF);
+	block[3] = (uint8_t)(best.c1 >> 8);
+	std::memcpy(block + 4, &best.indices, 4); // little endian like the format
+}
+
+static void DecodeColorBlock(const uint8_t block[8], uint8_t rgba[64], bool alwaysFourColors)
+{
+	uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+	uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+
+	uint32_t indices;
+	std::memcpy(&indices, block + 4, 4);
+
+	int palette[4][4];
+	GetColorPalette(c0, c1, alwaysFourColors || c0 > c1, palette);
+
+	for (int i = 0; i < 16; i++)
+	{
+		const int* color = palette[(indices >> (2 * i)) & 3];
+
+		for (int c = 0; c < 4; c++)
+			rgba[i * 4 + c] = (uint8_t)color[c];
+	}
+}
+
+/* alpha block */
+
+static void GetAlphaPalette(int a0, int a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+
+	if (a0 > a1)
+	{
+		for (int i = 2; i < 8; i++)
+			palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+	}
+	else
+	{
+		for (int i = 2; i < 6; i++)
+			palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void EncodeAlphaBlock(const uint8_t rgba[64], uint8_t block[8])
+{
+	int minAlpha = 255, maxAlpha = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		minAlpha = std::min(minAlpha, (int)rgba[i * 4 + 3]);
+		maxAlpha = std::max(maxAlpha, (int)rgba[i * 4 + 3]);
+	}
+
+	// eight interpolated values between the extremes (a0 > a1), a single value when they are equal
+
+	int palette[8];
+	GetAlphaPalette(maxAlpha, minAlpha, palette);
+
+	uint64_t indices = 0;
+
+	for (int i = 0; i < 16; i++)
+	{
+		int alpha = rgba[i * 4 + 3];
+		int bestIndex = 0;
+
+		for (int p = 1; p < 8; p++)
+		{
+			if (std::abs(palette[p] - alpha) < std::abs(palette[bestIndex] - alpha))
+				bestIndex = p;
+		}
+
+		indices |= (uint64_t)bestIndex << (3 * i);
+	}
+
+	block[0] = (uint8_t)maxAlpha;
+	block[1] = (uint8_t)minAlpha;
+
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = (uint8_t)(indices >> (8 * i));
+}
+
+static void DecodeAlphaBlock(const uint8_t block[8], uint8_t rgba[64])
+{
+	int palette[8];
+	GetAlphaPalette(block[0], block[1], palette);
+
+	uint64_t indices = 0;
+
+	for (int i = 0; i < 6; i++)
+		indices |= (uint64_t)block[2 + i] << (8 * i);
+
+	for (int i = 0; i < 16; i++)
+		rgba[i * 4 + 3] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+}
+
+/* blocks */
+
+void EncodeBC1Block(const uint8_t rgba[64], uint8_t block[8])
+{
+	EncodeColorBlock(rgba, block, true);
+}
+
+void EncodeBC3Block(const uint8_t rgba[64], uint8_t block[16])
+{
+	EncodeAlphaBlock(rgba, block);
+	EncodeColorBlock(rgba, block + 8, false);
+}
+
+void DecodeBC1Block(const uint8_t block[8], uint8_t rgba[64])
+{
+	DecodeColorBlock(block, rgba, false);
+}
+
+void DecodeBC3Block(const uint8_t block[16], uint8_t rgba[64])
+{
+	DecodeColorBlock(block + 8, rgba, true);
+	DecodeAlphaBlock(block, rgba);
+}
+
+/* images */
+
+static void CompressBlockRow(TextureFormat format, int width, int height, const unsigned char* pixels, int blockY, unsigned char* output)
+{
+	const int blockSize = format == TextureFormat::BC1 ? 8 : 16;
+	const int blocksX = (width + 3) / 4;
+
+	uint8_t rgba[64];
+
+	for (int blockX = 0; blockX < blocksX; blockX++)
+	{
+		// the pixels outside of the image repeat the last row and column
+
+		for (int y = 0; y < 4; y++)
+		{
+			int srcY = std::min(blockY * 4 + y, height - 1);
+
+			for (int x = 0; x < 4; x++)
+			{
+				int srcX = std::min(blockX * 4 + x, width - 1);
+				std::memcpy(&rgba[(y * 4 + x) * 4], pixels + ((size_t)srcY * width + srcX) * 4, 4);
+			}
+		}
+
+		if (format == TextureFormat::BC1)
+			EncodeBC1Block(rgba, output + (size_t)blockX * blockSize);
+		else
+			EncodeBC3Block(rgba, output + (size_t)blockX * blockSize);
+	}
+}
+
+std::vector<unsigned char> CompressImage(TextureFormat format, int width, int height, const unsigned char* pixels, ThreadPool* threadPool)
+{
+	const int blockSize = format == TextureFormat::BC1 ? 8 : 16;
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	const size_t rowSize = (size_t)blocksX * blockSize;
+
+	std::vector<unsigned char> blocks(GetTextureFormatSize(format, width, height));
+	unsigned char* output = blocks.data();
+
+	for (int blockY = 0; blockY < blocksY; blockY++)
+	{
+		if (threadPool != nullptr)
+			threadPool->PushTask([=]() { CompressBlockRow(format, width, height, pixels, blockY, output + blockY * rowSize); });
+		else
+			CompressBlockRow(format, width, height, pixels, blockY, output + blockY * rowSize);
+	}
+
+	if (threadPool != nullptr)
+		threadPool->Wait();
+
+	return blocks;
+}
+
+std::vector<unsigned char> DecompressImage(TextureFormat format, int width, int height, const unsigned char* blocks)
+{
+	const int blockSize = format == TextureFormat::BC1 ? 8 : 16;
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+
+	std::vector<unsigned char> pixels((size_t)width * height * 4);
+	uint8_t rgba[64];
+
+	for (int blockY = 0; blockY < blocksY; blockY++)
+	{
+		for (int blockX = 0; blockX < blocksX; blockX++)
+		{
+			const unsigned char* block = blocks + ((size_t)blockY * blocksX + blockX) * blockSize;
+
+			if (format == TextureFormat::BC1)
+				DecodeBC1Block(block, rgba);
+			else
+				DecodeBC3Block(block, rgba);
+
+			for (int y = 0; y < 4 && blockY * 4 + y < height; y++)
+			{
+				for (int x = 0; x < 4 && blockX * 4 + x < width; x++)
+					std::memcpy(&pixels[((size_t)(blockY * 4 + y) * width + blockX * 4 + x) * 4], &rgba[(y * 4 + x) * 4], 4);
+			}
+		}
+	}
+
+	return pixels;
+}
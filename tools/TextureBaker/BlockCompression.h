@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Core/Renderer/TextureFile.h"
+
+class ThreadPool;
+
+// BC1 / BC3 encoder for the baked textures: principal axis endpoints refined with a least squares fit,
+// the blocks follow the rows of the image in memory (bottom to top, like the mips of the file)
+
+void EncodeBC1Block(const uint8_t rgba[64], uint8_t block[8]); // pixels with alpha under 128 are transparent
+void EncodeBC3Block(const uint8_t rgba[64], uint8_t block[16]);
+
+void DecodeBC1Block(const uint8_t block[8], uint8_t rgba[64]);
+void DecodeBC3Block(const uint8_t block[16], uint8_t rgba[64]);
+
+// whole images, the rows of blocks are split between the threads of the pool (serial without it)
+
+std::vector<unsigned char> CompressImage(TextureFormat format, int width, int height, const unsigned char* pixels, ThreadPool* threadPool);
+std::vector<unsigned char> DecompressImage(TextureFormat format, int width, int height, const unsigned char* blocks);
@@ -0,0 +1,216 @@
+// bakes images into .btex files (Core/Renderer/TextureFile.h), the runtime maps them and uploads the mips
+// without decoding anything
+//
+// usage: TextureBaker [options] <input image> <output.btex>
+//        TextureBaker [options] <input images...> <output directory>
+//
+// options: --format rgba8|bc1|bc3   bc1 is 8x smaller (1 bit alpha), bc3 4x (smooth alpha), rgba8 by default
+//          --no-mips                only the base level
+//          --threads <n>            threads of the block encoder, all the cores by default
+//          --min-psnr <dB>          fail (and do not write) the textures that compress worse than this
+//          --premultiply            color multiplied by alpha, drawn with BlendMode::PREMULTIPLIED_ALPHA
+//          --linear-mips            mips averaged on the stored values (normal maps, masks), in linear light by default
+//
+// build from the root of the repository with the engine sources it uses:
+// g++ -std=c++17 -O2 -pthread -Iinclude -Ivendor tools/TextureBaker/main.cpp tools/TextureBaker/BlockCompression.cpp
+//     src/Core/Renderer/TextureFile.cpp src/Core/Renderer/ImageKernels.cpp src/Core/MappedFile.cpp src/Core/ThreadPool.cpp vendor/stb_image/stb_image.cpp -o TextureBaker
+
+#include "Core/Renderer/TextureFile.h"
+#include "Core/Renderer/ImageKernels.h"
+#include "Core/ThreadPool.h"
+#include "BlockCompression.h"
+#include <stb_image/stb_image.h>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+struct BakeOptions
+{
+	TextureFormat format = TextureFormat::RGBA8;
+	bool mips = true;
+	bool premultiply = false;
+	bool srgbMips = true;
+	float minPsnr = 0.0f;
+};
+
+// psnr of the color premultiplied by alpha (what ends up blended on screen, the color under the
+// transparent pixels of BC1 does not count) or of the alpha, infinite when they are equal
+
+static double ComputePsnr(const unsigned char* a, const unsigned char* b, size_t pixelsCount, bool alpha)
+{
+	double sum = 0.0;
+
+	for (size_t i = 0; i < pixelsCount; i++)
+	{
+		const unsigned char* pa = a + i * 4;
+		const unsigned char* pb = b + i * 4;
+
+		if (alpha)
+		{
+			double d = (double)pa[3] - (double)pb[3];
+			sum += d * d;
+			continue;
+		}
+
+		for (int c = 0; c < 3; c++)
+		{
+			double d = ((double)pa[c] * pa[3] - (double)pb[c] * pb[3]) / 255.0;
+			sum += d * d;
+		}
+	}
+
+	double mse = sum / ((double)pixelsCount * (alpha ? 1 : 3));
+
+	return mse == 0.0 ? INFINITY : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+static bool BakeTexture(const std::string& input, const std::string& output, const BakeOptions& options, ThreadPool& threadPool)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// same orientation as Texture::Load
+
+	int width, height, channels;
+	unsigned char* pixels = ImageKernels::LoadRGBA(input, &width, &height, &channels);
+
+	if (pixels == nullptr)
+	{
+		std::cout << "[ERROR] Texture loading \"" << input << "\": " << stbi_failure_reason() << std::endl;
+		return false;
+	}
+
+	if (options.premultiply)
+		ImageKernels::PremultiplyAlpha(pixels, (size_t)width * height);
+
+	std::vector<TextureMip> chain = TextureFile::GenerateMips(width, height, pixels, options.mips, options.srgbMips);
+	stbi_image_free(pixels);
+
+	size_t rawSize = 0;
+
+	for (const TextureMip& mip : chain)
+		rawSize += mip.pixels.size();
+
+	// block compression, the quality is measured on the base level
+
+	std::string quality;
+
+	if (IsCompressedFormat(options.format))
+	{
+		std::vector<unsigned char> base = chain[0].pixels;
+
+		for (TextureMip& mip : chain)
+			mip.pixels = CompressImage(options.format, mip.width, mip.height, mip.pixels.data(), &threadPool);
+
+		std::vector<unsigned char> decoded = DecompressImage(options.format, width, height, chain[0].pixels.data());
+
+		double psnr = ComputePsnr(base.data(), decoded.data(), (size_t)width * height, false);
+		double alphaPsnr = ComputePsnr(base.data(), decoded.data(), (size_t)width * height, true);
+
+		quality = ", psnr " + std::to_string(psnr).substr(0, 5) + " dB, alpha " + std::to_string(alphaPsnr).substr(0, 5) + " dB";
+
+		if (psnr < options.minPsnr)
+		{
+			std::cout << "[ERROR] " << input << ": psnr " << psnr << " dB under " << options.minPsnr << " dB, not written" << std::endl;
+			return false;
+		}
+	}
+
+	if (!TextureFile::Save(output, options.format, chain))
+		return false;
+
+	// check that the runtime accepts it
+
+	TextureFile file;
+
+	if (!file.Open(output))
+		return false;
+
+	size_t bakedSize = 0;
+
+	for (const TextureMip& mip : chain)
+		bakedSize += mip.pixels.size();
+
+	float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "[INFO] " << input << " -> " << output << " (" << width << "x" << height << " " << GetTextureFormatName(options.format) << ", " << chain.size() << " mips, "
+		<< rawSize / 1024 << " KiB -> " << bakedSize / 1024 << " KiB, " << (float)rawSize / (float)bakedSize << "x" << quality << ", " << ms << " ms)" << std::endl;
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BakeOptions options;
+	int threads = (int)std::thread::hardware_concurrency();
+	std::vector<std::string> paths;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+
+		if (arg == "--no-mips")
+			options.mips = false;
+		else if (arg == "--premultiply")
+			options.premultiply = true;
+		else if (arg == "--linear-mips")
+			options.srgbMips = false;
+		else if (arg == "--format" && i + 1 < argc)
+		{
+			std::string format = argv[++i];
+
+			if (format == "rgba8")
+				options.format = TextureFormat::RGBA8;
+			else if (format == "bc1")
+				options.format = TextureFormat::BC1;
+			else if (format == "bc3")
+				options.format = TextureFormat::BC3;
+			else
+			{
+				std::cout << "[ERROR] Unknown format \"" << format << "\" (rgba8, bc1 or bc3)" << std::endl;
+				return 1;
+			}
+		}
+		else if (arg == "--threads" && i + 1 < argc)
+			threads = std::max(std::atoi(argv[++i]), 1);
+		else if (arg == "--min-psnr" && i + 1 < argc)
+			options.minPsnr = (float)std::atof(argv[++i]);
+		else
+			paths.push_back(arg);
+	}
+
+	if (paths.size() < 2)
+	{
+		std::cout << "usage: TextureBaker [--format rgba8|bc1|bc3] [--no-mips] [--threads n] [--min-psnr dB] [--premultiply] [--linear-mips] <input image> <output.btex>" << std::endl;
+		std::cout << "       TextureBaker [options] <input images...> <output directory>" << std::endl;
+		return 1;
+	}
+
+	ThreadPool threadPool(threads);
+
+	std::filesystem::path output = paths.back();
+	paths.pop_back();
+
+	// several inputs (or a directory as the output) keep the names and change the extension
+
+	bool toDirectory = paths.size() > 1 || std::filesystem::is_directory(output);
+
+	if (toDirectory)
+		std::filesystem::create_directories(output);
+
+	int failed = 0;
+
+	for (const std::string& input : paths)
+	{
+		std::filesystem::path target = toDirectory ? output / std::filesystem::path(input).filename().replace_extension(".btex") : output;
+
+		if (!BakeTexture(input, target.string(), options, threadPool))
+			failed++;
+	}
+
+	return failed == 0 ? 0 : 1;
+}